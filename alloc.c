@@ -0,0 +1,330 @@
+#include "alloc.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALIGN16(n) (((n) + 15) & ~(size_t)15)
+
+// ----------------------------------------------------------
+// Convenience wrappers
+// ----------------------------------------------------------
+
+void* mem_alloc(Allocator* a, size_t size) {
+    if (!a) a = alloc_system();
+    return a->alloc(a, size);
+}
+
+void* mem_realloc(Allocator* a, void* p, size_t size) {
+    if (!a) a = alloc_system();
+    return a->resize(a, p, size);
+}
+
+void mem_free(Allocator* a, void* p) {
+    if (!p) return;
+    if (!a) a = alloc_system();
+    a->release(a, p);
+}
+
+char* mem_strdup(Allocator* a, const char* s) {
+    return mem_strndup(a, s, strlen(s));
+}
+
+char* mem_strndup(Allocator* a, const char* s, size_t n) {
+    size_t len = strnlen(s, n);
+    char* copy = mem_alloc(a, len + 1);
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+// ----------------------------------------------------------
+// System allocator
+// ----------------------------------------------------------
+
+static void* sys_alloc(Allocator* a, size_t size) {
+    (void)a;
+    void* p = calloc(1, size ? size : 1);
+    if (!p) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+static void* sys_resize(Allocator* a, void* p, size_t size) {
+    (void)a;
+    void* q = realloc(p, size ? size : 1);
+    if (!q) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    return q;
+}
+
+static void sys_release(Allocator* a, void* p) {
+    (void)a;
+    free(p);
+}
+
+Allocator* alloc_system(void) {
+    static Allocator sys = { sys_alloc, sys_resize, sys_release };
+    return &sys;
+}
+
+// ----------------------------------------------------------
+// Arena allocator
+// ----------------------------------------------------------
+// Each block is preceded by a 16-byte header holding its size so
+// resize can copy; release is a no-op and memory returns on reset.
+// Chunk data starts 16-byte aligned (the backing allocator returns
+// 16-byte aligned memory), so every block handed out is as well.
+
+typedef struct ArenaChunk {
+    struct ArenaChunk* next;
+    size_t size;
+    size_t used;
+    _Alignas(16) unsigned char data[];
+} ArenaChunk;
+
+_Static_assert(offsetof(ArenaChunk, data) % 16 == 0, "arena blocks must stay 16-byte aligned");
+
+typedef struct {
+    Allocator base;
+    Allocator* backing;
+    ArenaChunk* head;
+    size_t chunk_size;
+    void* last;          // most recent block (can grow in place)
+} Arena;
+
+static ArenaChunk* arena_chunk(Arena* ar, size_t need) {
+    size_t size = need > ar->chunk_size ? need : ar->chunk_size;
+    ArenaChunk* c = mem_alloc(ar->backing, sizeof(ArenaChunk) + size);
+    c->size = size;
+    c->used = 0;
+    c->next = ar->head;
+    ar->head = c;
+    return c;
+}
+
+static void* arena_alloc(Allocator* a, size_t size) {
+    Arena* ar = (Arena*)a;
+    size_t need = 16 + ALIGN16(size);
+    ArenaChunk* c = ar->head;
+    if (!c || c->size - c->used < need) c = arena_chunk(ar, need);
+
+    unsigned char* block = c->data + c->used;
+    c->used += need;
+    *(size_t*)block = size;
+    memset(block + 16, 0, size);
+    ar->last = block + 16;
+    return block + 16;
+}
+
+static void* arena_resize(Allocator* a, void* p, size_t size) {
+    Arena* ar = (Arena*)a;
+    if (!p) return arena_alloc(a, size);
+
+    size_t old = *(size_t*)((unsigned char*)p - 16);
+    ArenaChunk* c = ar->head;
+    if (p == ar->last) {
+        size_t start = (unsigned char*)p - c->data;
+        if (start + ALIGN16(size) <= c->size) {
+            c->used = start + ALIGN16(size);
+            *(size_t*)((unsigned char*)p - 16) = size;
+            return p;
+        }
+    }
+    void* q = arena_alloc(a, size);
+    memcpy(q, p, old < size ? old : size);
+    return q;
+}
+
+static void arena_release(Allocator* a, void* p) {
+    (void)a;
+    (void)p;
+}
+
+Allocator* arena_new(Allocator* backing, size_t chunk_size) {
+    Arena* ar = mem_alloc(backing, sizeof(Arena));
+    ar->base = (Allocator){ arena_alloc, arena_resize, arena_release };
+    ar->backing = backing;
+    ar->chunk_size = chunk_size ? chunk_size : 64 * 1024;
+    return &ar->base;
+}
+
+void arena_reset(Allocator* a) {
+    Arena* ar = (Arena*)a;
+    while (ar->head && ar->head->next) {
+        ArenaChunk* next = ar->head->next;
+        mem_free(ar->backing, ar->head);
+        ar->head = next;
+    }
+    if (ar->head) ar->head->used = 0;
+    ar->last = NULL;
+}
+
+void arena_destroy(Allocator* a) {
+    if (!a) return;
+    Arena* ar = (Arena*)a;
+    while (ar->head) {
+        ArenaChunk* next = ar->head->next;
+        mem_free(ar->backing, ar->head);
+        ar->head = next;
+    }
+    mem_free(ar->backing, ar);
+}
+
+// ----------------------------------------------------------
+// Tracking allocator
+// ----------------------------------------------------------
+// Every live block is linked into a list through a header, tagged with
+// the phase that allocated it. Counters are kept per phase.
+
+#define MAX_PHASES 16
+
+typedef struct TrackHeader {
+    struct TrackHeader* prev;
+    struct TrackHeader* next;
+    size_t size;
+    unsigned long id;
+    int phase;
+} TrackHeader;
+
+#define TRACK_HDR ALIGN16(sizeof(TrackHeader))
+
+typedef struct {
+    const char* name;
+    long allocs;
+    long frees;
+    long live_bytes;
+    long peak_bytes;
+    long total_bytes;
+} PhaseStats;
+
+typedef struct {
+    Allocator base;
+    Allocator* backing;
+    TrackHeader* live;
+    unsigned long next_id;
+    long live_bytes;
+    long peak_bytes;
+    PhaseStats phases[MAX_PHASES];
+    int phase_count;
+    int phase;
+} Tracker;
+
+static void track_link(Tracker* t, TrackHeader* h, size_t size, int phase) {
+    h->size = size;
+    h->phase = phase;
+    h->id = t->next_id++;
+    h->prev = NULL;
+    h->next = t->live;
+    if (t->live) t->live->prev = h;
+    t->live = h;
+
+    PhaseStats* ps = &t->phases[phase];
+    ps->allocs++;
+    ps->total_bytes += size;
+    ps->live_bytes += size;
+    if (ps->live_bytes > ps->peak_bytes) ps->peak_bytes = ps->live_bytes;
+    t->live_bytes += size;
+    if (t->live_bytes > t->peak_bytes) t->peak_bytes = t->live_bytes;
+}
+
+static void track_unlink(Tracker* t, TrackHeader* h) {
+    if (h->prev) h->prev->next = h->next;
+    else t->live = h->next;
+    if (h->next) h->next->prev = h->prev;
+
+    PhaseStats* ps = &t->phases[h->phase];
+    ps->frees++;
+    ps->live_bytes -= h->size;
+    t->live_bytes -= h->size;
+}
+
+static void* track_alloc(Allocator* a, size_t size) {
+    Tracker* t = (Tracker*)a;
+    TrackHeader* h = mem_alloc(t->backing, TRACK_HDR + size);
+    track_link(t, h, size, t->phase);
+    return (unsigned char*)h + TRACK_HDR;
+}
+
+static void* track_resize(Allocator* a, void* p, size_t size) {
+    Tracker* t = (Tracker*)a;
+    if (!p) return track_alloc(a, size);
+
+    TrackHeader* h = (TrackHeader*)((unsigned char*)p - TRACK_HDR);
+    int phase = h->phase;
+    track_unlink(t, h);
+    t->phases[phase].frees--;   // a resize is not a free
+    t->phases[phase].allocs--;  // ...nor a fresh allocation
+    h = mem_realloc(t->backing, h, TRACK_HDR + size);
+    track_link(t, h, size, phase);
+    return (unsigned char*)h + TRACK_HDR;
+}
+
+static void track_release(Allocator* a, void* p) {
+    Tracker* t = (Tracker*)a;
+    TrackHeader* h = (TrackHeader*)((unsigned char*)p - TRACK_HDR);
+    track_unlink(t, h);
+    mem_free(t->backing, h);
+}
+
+Allocator* tracking_new(Allocator* backing) {
+    Tracker* t = mem_alloc(NULL, sizeof(Tracker));
+    t->base = (Allocator){ track_alloc, track_resize, track_release };
+    t->backing = backing ? backing : alloc_system();
+    t->phases[0].name = "(init)";
+    t->phase_count = 1;
+    return &t->base;
+}
+
+void tracking_set_phase(Allocator* a, const char* phase) {
+    Tracker* t = (Tracker*)a;
+    for (int i = 0; i < t->phase_count; i++) {
+        if (strcmp(t->phases[i].name, phase) == 0) {
+            t->phase = i;
+            return;
+        }
+    }
+    if (t->phase_count == MAX_PHASES) return;
+    t->phases[t->phase_count].name = phase;
+    t->phase = t->phase_count++;
+}
+
+void tracking_report(Allocator* a, FILE* out) {
+    Tracker* t = (Tracker*)a;
+    fprintf(out, "%-12s %10s %10s %12s %12s %12s\n",
+            "phase", "allocs", "frees", "total bytes", "peak bytes", "live bytes");
+    for (int i = 0; i < t->phase_count; i++) {
+        PhaseStats* ps = &t->phases[i];
+        if (ps->allocs == 0) continue;
+        fprintf(out, "%-12s %10ld %10ld %12ld %12ld %12ld\n",
+                ps->name, ps->allocs, ps->frees, ps->total_bytes, ps->peak_bytes, ps->live_bytes);
+    }
+    fprintf(out, "%-12s %10s %10s %12s %12ld %12ld\n",
+            "total", "", "", "", t->peak_bytes, t->live_bytes);
+}
+
+long tracking_report_leaks(Allocator* a, FILE* out) {
+    Tracker* t = (Tracker*)a;
+    long n = 0;
+    for (TrackHeader* h = t->live; h; h = h->next) {
+        fprintf(out, "leak: #%lu %zu bytes (phase %s)\n",
+                h->id, h->size, t->phases[h->phase].name);
+        n++;
+    }
+    return n;
+}
+
+void tracking_destroy(Allocator* a) {
+    if (!a) return;
+    Tracker* t = (Tracker*)a;
+    while (t->live) {
+        TrackHeader* h = t->live;
+        t->live = h->next;
+        mem_free(t->backing, h);
+    }
+    mem_free(NULL, t);
+}
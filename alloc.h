@@ -0,0 +1,43 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// ==========================================================
+// Allocator interface
+//
+// Every phase allocates through an Allocator* instead of calling
+// malloc/calloc/strdup/realloc directly. Passing NULL anywhere an
+// Allocator* is expected selects the system allocator.
+// ==========================================================
+
+typedef struct Allocator Allocator;
+
+struct Allocator {
+    void* (*alloc)(Allocator* a, size_t size);           // zero-filled
+    void* (*resize)(Allocator* a, void* p, size_t size); // realloc semantics
+    void  (*release)(Allocator* a, void* p);             // free(NULL) is a no-op
+};
+
+// ---------- Convenience wrappers ----------
+void* mem_alloc(Allocator* a, size_t size);
+void* mem_realloc(Allocator* a, void* p, size_t size);
+void  mem_free(Allocator* a, void* p);
+char* mem_strdup(Allocator* a, const char* s);
+char* mem_strndup(Allocator* a, const char* s, size_t n);
+
+// ---------- System allocator (malloc/free) ----------
+Allocator* alloc_system(void);
+
+// ---------- Arena: bump allocation, freed all at once ----------
+Allocator* arena_new(Allocator* backing, size_t chunk_size);
+void arena_reset(Allocator* arena);     // keep the first chunk, drop the rest
+void arena_destroy(Allocator* arena);
+
+// ---------- Tracking: per-phase accounting and leak report ----------
+Allocator* tracking_new(Allocator* backing);
+void tracking_set_phase(Allocator* tracker, const char* phase);
+void tracking_report(Allocator* tracker, FILE* out);
+// Lists every block still live; returns how many there were.
+long tracking_report_leaks(Allocator* tracker, FILE* out);
+void tracking_destroy(Allocator* tracker);
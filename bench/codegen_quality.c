@@ -0,0 +1,892 @@
+// ==========================================================
+// Generated-code quality benchmark
+//
+// Compiles a corpus of Jive programs (main.jive plus generated stress
+// programs) through the pass manager and stack_machine_emit under each
+// pipeline config and reports, per program, the static instruction mix
+// of the assembly:
+// instructions, push/pop, memory loads/stores and idiv, plus code bytes
+// from the emitter's size model. With --run the IR is executed by
+// ir_interpret to count dynamic IR ops, and the emitted assembly itself
+// is executed (see below) to check that it computes what its IR does
+// and that every config computes the same result.
+//
+// Build (from the repo root):
+//   gcc -O2 -I. -o codegen_quality bench/codegen_quality.c alloc.c lexer.c
+//       parser.c symbol_table.c codegen.c constprop.c callgraph.c inline.c flat_ast.c
+//       regalloc.c cfg.c loopopt.c passes.c stack_machine.c stack_machine_ir.c
+// Run:
+//   ./codegen_quality [--run] [--update] [--baseline bench/codegen_quality.baseline]
+//
+// Exits 1 if any metric is worse than the checked-in baseline.
+// ==========================================================
+#include <ctype.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parser.h"
+#include "symbol_table.h"
+#include "codegen.h"
+#include "callgraph.h"
+#include "passes.h"
+#include "stack_machine.h"
+#include "stack_machine_ir.h"
+
+SymStack* g_symstack = NULL;
+
+#define MAX_ROWS 64
+
+typedef struct {
+    long insns;
+    long pushes;
+    long pops;
+    long loads;
+    long stores;
+    long idivs;
+    long bytes;
+} AsmStats;
+
+typedef struct {
+    char program[64];
+    char config[16];
+    AsmStats s;
+} Row;
+
+// A pipeline is chosen with the driver's own pass-manager options, so
+// each row measures what `compiler <options>` would emit
+typedef struct {
+    const char* name;
+    const char* passes;  // pm_parse_option argument
+    bool regalloc;
+    bool size_opt;
+} Config;
+
+static const Config configs[] = {
+    { "O0",       "-O0",              false, false },
+    { "regalloc", "-O0",              true,  false },
+    { "loopopt",  "-passes=loop-opt", false, false },
+    { "default",  "-O2",              false, false },
+    { "Os",       "-O2",              false, true  },
+};
+#define CONFIG_COUNT (int)(sizeof configs / sizeof configs[0])
+
+// ----------------------------------------------------------
+// Corpus
+// ----------------------------------------------------------
+
+typedef struct {
+    char* buf;
+    size_t len;
+    size_t cap;
+} StrBuf;
+
+static void sb_printf(StrBuf* b, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if (b->len + n + 1 > b->cap) {
+        b->cap = (b->len + n + 1) * 2;
+        b->buf = realloc(b->buf, b->cap);
+    }
+    va_start(ap, fmt);
+    vsnprintf(b->buf + b->len, n + 1, fmt, ap);
+    va_end(ap);
+    b->len += n;
+}
+
+// let-chain: every variable depends on the previous one
+static char* gen_chain(int n) {
+    static const char ops[] = "+-*";
+    StrBuf b = {0};
+    sb_printf(&b, "fn main() -> int {\n    let v0: int = 1;\n");
+    for (int i = 1; i < n; i++)
+        sb_printf(&b, "    let v%d: int = v%d %c %d;\n", i, i - 1, ops[i % 3], i % 7 + 1);
+    sb_printf(&b, "    return v%d %% 251;\n}\n", n - 1);
+    return b.buf;
+}
+
+// one wide expression reading many variables
+static char* gen_wide(int n) {
+    StrBuf b = {0};
+    sb_printf(&b, "fn main() -> int {\n");
+    for (int i = 0; i < n; i++) sb_printf(&b, "    let x%d: int = %d;\n", i, i * 3 + 1);
+    sb_printf(&b, "    return x0");
+    for (int i = 1; i < n; i++) sb_printf(&b, " %c x%d", (i % 2) ? '+' : '-', i);
+    sb_printf(&b, ";\n}\n");
+    return b.buf;
+}
+
+// repeated reassignment of a few variables, with division and modulo
+static char* gen_divmod(int n) {
+    StrBuf b = {0};
+    sb_printf(&b, "fn main() -> int {\n    let a: int = 1000;\n    let b: int = 7;\n");
+    for (int i = 0; i < n; i++) {
+        sb_printf(&b, "    set a = a * %d / b + %d;\n", i % 5 + 2, i);
+        sb_printf(&b, "    set b = a %% 13 + 1;\n");
+    }
+    sb_printf(&b, "    return a %% 256;\n}\n");
+    return b.buf;
+}
+
+// many small helpers, only a few of them reachable from main
+static char* gen_calls(int n) {
+    StrBuf b = {0};
+    for (int i = 0; i < n; i++)
+        sb_printf(&b, "fn h%d(a: int, b: int) -> int {\n    return a * %d + b;\n}\n", i, i + 1);
+    sb_printf(&b, "fn main() -> int {\n    let x: int = 1;\n");
+    for (int i = 0; i < n; i += 10) sb_printf(&b, "    set x = h%d(x, %d) %% 1000;\n", i, i);
+    sb_printf(&b, "    return x %% 256;\n}\n");
+    return b.buf;
+}
+
+// a loop over parameters: invariant products and i * k induction uses
+static char* gen_loop(int n) {
+    StrBuf b = {0};
+    sb_printf(&b, "fn loop(n: int, a: int, b: int) -> int {\n");
+    sb_printf(&b, "    let i: int = 0;\n    let s: int = 0;\n");
+    sb_printf(&b, "    while i < n {\n");
+    sb_printf(&b, "        set s = s + (a * b) + (i * 8);\n");
+    sb_printf(&b, "        set s = (s + (i * 8) + (a * b % 7)) %% 65521;\n");
+    sb_printf(&b, "        set i = i + 1;\n    }\n    return s;\n}\n");
+    sb_printf(&b, "fn main() -> int {\n    return loop(%d, 3, 5) %% 256;\n}\n", n);
+    return b.buf;
+}
+
+// sequential blocks, each shadowing x twice: frame slots are reused
+static char* gen_scopes(int n) {
+    StrBuf b = {0};
+    sb_printf(&b, "fn main() -> int {\n    let x: int = 3;\n    let acc: int = 0;\n");
+    for (int i = 0; i < n; i++) {
+        sb_printf(&b, "    {\n        let x: int = (x + %d);\n", i);
+        sb_printf(&b, "        {\n            let x: int = ((x * 3) %% 17);\n");
+        sb_printf(&b, "            set acc = ((acc + x) %% 1000);\n        }\n    }\n");
+    }
+    sb_printf(&b, "    return ((acc + x) %% 256);\n}\n");
+    return b.buf;
+}
+
+static char* read_file(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* src = malloc(len + 1);
+    len = (long)fread(src, 1, len, f);
+    src[len] = '\0';
+    fclose(f);
+    return src;
+}
+
+// ----------------------------------------------------------
+// Executing the emitted assembly
+// ----------------------------------------------------------
+// The regalloc and Os configs produce the same IR as others and differ
+// only inside stack_machine_emit, so interpreting the IR says nothing
+// about their code. With --run the assembly text itself is executed by
+// a small interpreter for the x86-64 subset the emitter writes (no
+// assembler needed). Beyond the result it checks the ABI rules the
+// emitter relies on: rsp is 16-byte aligned at every call, a callee
+// preserves rbx, rbp, r12-r15 and rsp, and nothing reads a caller-saved
+// register across a call (they are scrambled on return).
+
+enum { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15, NREGS };
+
+static const char* const reg64[NREGS] = {
+    "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+    "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15",
+};
+static const char* const reg32[NREGS] = {
+    "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+    "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d",
+};
+static const int callee_saved[] = { RBX, RBP, R12, R13, R14, R15 };
+#define CALLEE_SAVED_COUNT (int)(sizeof callee_saved / sizeof callee_saved[0])
+
+typedef enum {
+    X_PUSH, X_POP, X_MOV, X_MOVZX, X_ADD, X_SUB, X_IMUL, X_CQO, X_IDIV, X_XOR, X_CMP, X_TEST,
+    X_SETL, X_SETLE, X_SETG, X_SETGE, X_SETE, X_SETNE, X_JMP, X_JZ, X_CALL, X_RET, X_LEAVE,
+    X_OP_COUNT
+} X86Op;
+
+static const char* const x86_names[X_OP_COUNT] = {
+    "push", "pop", "mov", "movzx", "add", "sub", "imul", "cqo", "idiv", "xor", "cmp", "test",
+    "setl", "setle", "setg", "setge", "sete", "setne", "jmp", "jz", "call", "ret", "leave",
+};
+
+typedef enum { OPD_REG, OPD_REG32, OPD_AL, OPD_IMM, OPD_MEM, OPD_TARGET } OperandKind;
+
+typedef struct {
+    OperandKind kind;
+    int reg;          // OPD_REG/OPD_REG32: the register, OPD_MEM: the base
+    long long value;  // OPD_IMM: value, OPD_MEM: displacement, OPD_TARGET: instruction index
+} X86Operand;
+
+typedef struct {
+    X86Op op;
+    int nops;
+    X86Operand opd[3];
+} X86Insn;
+
+typedef struct {
+    char name[80];    // "fn" or "fn.L3" / "fn.exit"
+    int at;           // instruction index
+} X86Label;
+
+typedef struct {
+    X86Insn* code;
+    int count;
+    X86Label* labels;
+    int label_count;
+    char error[160];  // why the text could not be loaded
+} X86Program;
+
+// Next line of text into buf; false at the end
+static bool next_line(const char** text, char* buf, size_t size) {
+    const char* line = *text;
+    if (!*line) return false;
+    const char* end = strchr(line, '\n');
+    if (!end) end = line + strlen(line);
+    size_t n = (size_t)(end - line) < size - 1 ? (size_t)(end - line) : size - 1;
+    memcpy(buf, line, n);
+    buf[n] = '\0';
+    *text = *end ? end + 1 : end;
+    return true;
+}
+
+// Local labels (.L3, .exit) are scoped to the function they appear in
+static void label_key(char* key, size_t size, const char* fn, const char* name) {
+    if (name[0] == '.') snprintf(key, size, "%.40s%.*s", fn, (int)size - 41, name);
+    else snprintf(key, size, "%.*s", (int)size - 1, name);
+}
+
+static int find_label(const X86Program* p, const char* key) {
+    for (int i = 0; i < p->label_count; i++) {
+        if (strcmp(p->labels[i].name, key) == 0) return p->labels[i].at;
+    }
+    return -1;
+}
+
+static int find_reg(const char* const* names, const char* s) {
+    for (int r = 0; r < NREGS; r++) {
+        if (strcmp(names[r], s) == 0) return r;
+    }
+    return -1;
+}
+
+static bool parse_operand(X86Program* p, const char* fn, char* s, X86Operand* out) {
+    while (isspace((unsigned char)*s)) s++;
+    if (strncmp(s, "qword ", 6) == 0) s += 6;
+    char* e = s + strlen(s);
+    while (e > s && isspace((unsigned char)e[-1])) *--e = '\0';
+
+    if (*s == '[') {
+        // [base], [base+disp] or [base-disp]
+        char base[8];
+        int k = 0;
+        s++;
+        while (isalnum((unsigned char)*s) && k < 7) base[k++] = *s++;
+        base[k] = '\0';
+        out->kind = OPD_MEM;
+        out->reg = find_reg(reg64, base);
+        out->value = (*s == '+' || *s == '-') ? strtoll(s, &s, 10) : 0;
+        return out->reg >= 0 && *s == ']';
+    }
+    if (isdigit((unsigned char)*s) || *s == '-') {
+        out->kind = OPD_IMM;
+        out->value = strtoll(s, &e, 10);
+        return *e == '\0';
+    }
+    if ((out->reg = find_reg(reg64, s)) >= 0) { out->kind = OPD_REG; return true; }
+    if ((out->reg = find_reg(reg32, s)) >= 0) { out->kind = OPD_REG32; return true; }
+    if (strcmp(s, "al") == 0) { out->kind = OPD_AL; out->reg = RAX; return true; }
+
+    char key[80];
+    label_key(key, sizeof key, fn, s);
+    out->kind = OPD_TARGET;
+    out->value = find_label(p, key);
+    return out->value >= 0;
+}
+
+// Two passes over the text: labels first, so jumps may point forward
+static bool x86_load(X86Program* p, const char* text) {
+    memset(p, 0, sizeof *p);
+    char buf[256], fn[64] = "";
+    int cap = 0, label_cap = 0, n = 0;
+
+    for (const char* t = text; next_line(&t, buf, sizeof buf);) {
+        if (strncmp(buf, "section", 7) == 0) break;  // data follows the code
+        if (buf[0] == ' ') {
+            if (buf[strspn(buf, " ")]) n++;
+            continue;
+        }
+        char* colon = strchr(buf, ':');
+        if (!colon) continue;  // global
+        *colon = '\0';
+        if (buf[0] != '.') snprintf(fn, sizeof fn, "%.*s", (int)sizeof fn - 1, buf);
+        if (p->label_count == label_cap) {
+            label_cap = label_cap ? label_cap * 2 : 64;
+            p->labels = realloc(p->labels, sizeof(X86Label) * label_cap);
+        }
+        X86Label* l = &p->labels[p->label_count++];
+        label_key(l->name, sizeof l->name, fn, buf);
+        l->at = n;
+    }
+
+    fn[0] = '\0';
+    for (const char* t = text; next_line(&t, buf, sizeof buf);) {
+        if (strncmp(buf, "section", 7) == 0) break;
+        if (buf[0] != ' ') {
+            char* colon = strchr(buf, ':');
+            if (colon && buf[0] != '.') {
+                *colon = '\0';
+                snprintf(fn, sizeof fn, "%.*s", (int)sizeof fn - 1, buf);
+            }
+            continue;
+        }
+        char* s = buf + strspn(buf, " ");
+        if (!*s) continue;
+
+        char mnem[16];
+        int k = 0;
+        while (*s && !isspace((unsigned char)*s) && k < 15) mnem[k++] = *s++;
+        mnem[k] = '\0';
+        if (p->count == cap) {
+            cap = cap ? cap * 2 : 256;
+            p->code = realloc(p->code, sizeof(X86Insn) * cap);
+        }
+        X86Insn* in = &p->code[p->count];
+        in->op = X_OP_COUNT;
+        for (int o = 0; o < X_OP_COUNT; o++) {
+            if (strcmp(x86_names[o], mnem) == 0) in->op = (X86Op)o;
+        }
+        in->nops = 0;
+        for (char* opd = strtok(s, ","); opd; opd = strtok(NULL, ",")) {
+            if (in->nops == 3 || !parse_operand(p, fn, opd, &in->opd[in->nops])) {
+                snprintf(p->error, sizeof p->error, "%s: cannot execute '%s'", fn, buf + strspn(buf, " "));
+                return false;
+            }
+            in->nops++;
+        }
+        if (in->op == X_OP_COUNT) {
+            snprintf(p->error, sizeof p->error, "%s: cannot execute '%s'", fn, mnem);
+            return false;
+        }
+        p->count++;
+    }
+    return true;
+}
+
+static void x86_free(X86Program* p) {
+    free(p->code);
+    free(p->labels);
+}
+
+#define X86_STACK_BYTES (4 << 20)
+#define X86_MAX_CALLS   10000
+#define X86_MAX_STEPS   200000000L
+#define X86_RETURN_TOP  (-1)  // return address pushed for the entry function
+
+typedef enum { X86_OK, X86_FAULT, X86_BROKEN } X86Status;
+
+typedef struct {
+    long long r[NREGS];
+    uint8_t* mem;
+    char* error;
+    size_t error_size;
+} X86State;
+
+static bool x86_broken(X86State* s, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(s->error, s->error_size, fmt, ap);
+    va_end(ap);
+    return false;
+}
+
+static bool x86_addr(X86State* s, long long addr) {
+    if (addr < 0 || addr > X86_STACK_BYTES - 8 || addr % 8)
+        return x86_broken(s, "stack access at %lld out of range", addr - X86_STACK_BYTES);
+    return true;
+}
+
+static bool x86_get(X86State* s, const X86Operand* o, long long* v) {
+    switch (o->kind) {
+        case OPD_REG:   *v = s->r[o->reg]; return true;
+        case OPD_REG32: *v = (uint32_t)s->r[o->reg]; return true;
+        case OPD_AL:    *v = s->r[RAX] & 0xff; return true;
+        case OPD_IMM:   *v = o->value; return true;
+        case OPD_MEM: {
+            long long addr = s->r[o->reg] + o->value;
+            if (!x86_addr(s, addr)) return false;
+            memcpy(v, s->mem + addr, 8);
+            return true;
+        }
+        default:
+            return x86_broken(s, "bad source operand");
+    }
+}
+
+static bool x86_set(X86State* s, const X86Operand* o, long long v) {
+    switch (o->kind) {
+        case OPD_REG:   s->r[o->reg] = v; return true;
+        case OPD_REG32: s->r[o->reg] = (uint32_t)v; return true;  // 32-bit writes zero-extend
+        case OPD_AL:    s->r[RAX] = (s->r[RAX] & ~0xffLL) | (v & 0xff); return true;
+        case OPD_MEM: {
+            long long addr = s->r[o->reg] + o->value;
+            if (!x86_addr(s, addr)) return false;
+            memcpy(s->mem + addr, &v, 8);
+            return true;
+        }
+        default:
+            return x86_broken(s, "bad destination operand");
+    }
+}
+
+static bool x86_push(X86State* s, long long v) {
+    s->r[RSP] -= 8;
+    X86Operand top = { OPD_MEM, RSP, 0 };
+    return x86_set(s, &top, v);
+}
+
+static bool x86_pop(X86State* s, long long* v) {
+    X86Operand top = { OPD_MEM, RSP, 0 };
+    if (!x86_get(s, &top, v)) return false;
+    s->r[RSP] += 8;
+    return true;
+}
+
+// Registers a call must give back, and what rsp is after its return
+typedef struct {
+    long long saved[CALLEE_SAVED_COUNT];
+    long long rsp;
+} CallFrame;
+
+static void snapshot(const X86State* s, CallFrame* f, long long rsp_after) {
+    for (int k = 0; k < CALLEE_SAVED_COUNT; k++) f->saved[k] = s->r[callee_saved[k]];
+    f->rsp = rsp_after;
+}
+
+static bool check_snapshot(X86State* s, const CallFrame* f, const char* what) {
+    for (int k = 0; k < CALLEE_SAVED_COUNT; k++) {
+        if (s->r[callee_saved[k]] != f->saved[k])
+            return x86_broken(s, "%s clobbers %s", what, reg64[callee_saved[k]]);
+    }
+    if (s->r[RSP] != f->rsp) return x86_broken(s, "%s leaves rsp off by %lld", what, s->r[RSP] - f->rsp);
+    return true;
+}
+
+// Run the function at instruction `entry` with no arguments
+static X86Status x86_run(const X86Program* p, int entry, long long* result,
+                         char* error, size_t error_size) {
+    X86State s = { .mem = malloc(X86_STACK_BYTES), .error = error, .error_size = error_size };
+    CallFrame* frames = malloc(sizeof(CallFrame) * (X86_MAX_CALLS + 1));
+    for (int r = 0; r < NREGS; r++) s.r[r] = 0x5a5a5a5a00000000LL + r;  // garbage, but recognizable
+    s.r[RSP] = X86_STACK_BYTES;
+    CallFrame top;
+    snapshot(&s, &top, X86_STACK_BYTES);
+    x86_push(&s, X86_RETURN_TOP);
+
+    X86Status status = X86_BROKEN;
+    long long cmp_a = 0, cmp_b = 0;  // flags, as the operands of the last cmp/test
+    int depth = 0;
+    int pc = entry;
+    bool ok = true;
+    for (long steps = 0; ok; steps++) {
+        if (steps == X86_MAX_STEPS) { ok = x86_broken(&s, "no return after %ld instructions", steps); break; }
+        if (pc < 0 || pc >= p->count) { ok = x86_broken(&s, "ran off the code"); break; }
+        const X86Insn* in = &p->code[pc++];
+        const X86Operand* a = &in->opd[0];
+        const X86Operand* b = &in->opd[1];
+        long long x = 0, y = 0;
+
+        switch (in->op) {
+            case X_PUSH:
+                ok = x86_get(&s, a, &x) && x86_push(&s, x);
+                break;
+            case X_POP:
+                ok = x86_pop(&s, &x) && x86_set(&s, a, x);
+                break;
+            case X_MOV:
+            case X_MOVZX:
+                ok = x86_get(&s, b, &x) && x86_set(&s, a, x);
+                break;
+            case X_ADD:
+            case X_SUB:
+            case X_XOR:
+                ok = x86_get(&s, a, &x) && x86_get(&s, b, &y);
+                if (!ok) break;
+                if (in->op == X_ADD) x = (long long)((unsigned long long)x + (unsigned long long)y);
+                else if (in->op == X_SUB) x = (long long)((unsigned long long)x - (unsigned long long)y);
+                else x ^= y;
+                ok = x86_set(&s, a, x);
+                break;
+            case X_IMUL:
+                // imul r, r/m or imul r, r/m, imm
+                ok = x86_get(&s, b, &x) && x86_get(&s, in->nops == 3 ? &in->opd[2] : a, &y);
+                if (ok) ok = x86_set(&s, a, (long long)((unsigned long long)x * (unsigned long long)y));
+                break;
+            case X_CQO:
+                s.r[RDX] = s.r[RAX] < 0 ? -1 : 0;
+                break;
+            case X_IDIV:
+                ok = x86_get(&s, a, &y);
+                if (!ok) break;
+                if (s.r[RDX] != (s.r[RAX] < 0 ? -1 : 0)) { ok = x86_broken(&s, "idiv without cqo"); break; }
+                if (y == 0 || (s.r[RAX] == LLONG_MIN && y == -1)) { status = X86_FAULT; ok = false; break; }
+                x = s.r[RAX];
+                s.r[RAX] = x / y;
+                s.r[RDX] = x % y;
+                break;
+            case X_CMP:
+            case X_TEST:
+                ok = x86_get(&s, a, &cmp_a) && x86_get(&s, b, &cmp_b);
+                if (in->op == X_TEST) { cmp_a &= cmp_b; cmp_b = 0; }
+                break;
+            case X_SETL:  ok = x86_set(&s, a, cmp_a < cmp_b); break;
+            case X_SETLE: ok = x86_set(&s, a, cmp_a <= cmp_b); break;
+            case X_SETG:  ok = x86_set(&s, a, cmp_a > cmp_b); break;
+            case X_SETGE: ok = x86_set(&s, a, cmp_a >= cmp_b); break;
+            case X_SETE:  ok = x86_set(&s, a, cmp_a == cmp_b); break;
+            case X_SETNE: ok = x86_set(&s, a, cmp_a != cmp_b); break;
+            case X_JMP:
+                pc = (int)a->value;
+                break;
+            case X_JZ:
+                if (cmp_a == cmp_b) pc = (int)a->value;
+                break;
+            case X_CALL:
+                if (s.r[RSP] % 16) { ok = x86_broken(&s, "call with rsp not 16-byte aligned"); break; }
+                if (depth == X86_MAX_CALLS) { status = X86_FAULT; ok = false; break; }  // runaway recursion
+                snapshot(&s, &frames[depth++], s.r[RSP]);
+                ok = x86_push(&s, pc);
+                pc = (int)a->value;
+                break;
+            case X_RET:
+                ok = x86_pop(&s, &x);
+                if (!ok) break;
+                if (x == X86_RETURN_TOP) {
+                    if (check_snapshot(&s, &top, "the entry function")) {
+                        *result = s.r[RAX];
+                        status = X86_OK;
+                    }
+                    ok = false;
+                    break;
+                }
+                if (depth == 0) { ok = x86_broken(&s, "ret to %lld without a call", x); break; }
+                if (!check_snapshot(&s, &frames[--depth], "a call")) { ok = false; break; }
+                for (int r = 0; r < NREGS; r++) {
+                    bool keep = r == RAX || r == RSP;
+                    for (int k = 0; k < CALLEE_SAVED_COUNT; k++) keep |= r == callee_saved[k];
+                    if (!keep) s.r[r] = 0x5a5a5a5a00000000LL + r + steps;
+                }
+                pc = (int)x;
+                break;
+            case X_LEAVE:
+                s.r[RSP] = s.r[RBP];
+                ok = x86_pop(&s, &s.r[RBP]);
+                break;
+            default:
+                ok = x86_broken(&s, "unknown instruction");
+                break;
+        }
+    }
+    free(frames);
+    free(s.mem);
+    return status;
+}
+
+// ----------------------------------------------------------
+// Static instruction mix of the emitted assembly
+// ----------------------------------------------------------
+
+static void count_asm(const char* text, AsmStats* st) {
+    memset(st, 0, sizeof *st);
+    char buf[256];
+    while (next_line(&text, buf, sizeof buf)) {
+        // instructions are indented; labels and directives are not
+        if (buf[0] != ' ') continue;
+        char* p = buf;
+        while (isspace((unsigned char)*p)) p++;
+        if (!*p) continue;
+
+        char mnem[16];
+        int k = 0;
+        while (*p && !isspace((unsigned char)*p) && k < 15) mnem[k++] = *p++;
+        mnem[k] = '\0';
+        if (strcmp(mnem, "dq") == 0 || strcmp(mnem, "dd") == 0 || strcmp(mnem, "times") == 0)
+            continue;
+
+        st->insns++;
+        if (strcmp(mnem, "push") == 0) st->pushes++;
+        if (strcmp(mnem, "pop") == 0) st->pops++;
+        if (strcmp(mnem, "idiv") == 0) st->idivs++;
+
+        // memory operands: destination first, then sources
+        char* comma = strchr(p, ',');
+        bool dst_mem = strchr(p, '[') && (!comma || strchr(p, '[') < comma);
+        bool src_mem = comma && strchr(comma, '[');
+        if (strcmp(mnem, "lea") == 0) continue;
+        if (!comma && dst_mem) {
+            if (strcmp(mnem, "pop") == 0) st->stores++;
+            else if (strcmp(mnem, "inc") == 0 || strcmp(mnem, "dec") == 0 ||
+                     strcmp(mnem, "neg") == 0 || strcmp(mnem, "not") == 0) { st->loads++; st->stores++; }
+            else st->loads++;
+        } else if (dst_mem) {
+            if (strcmp(mnem, "mov") == 0) st->stores++;
+            else if (strcmp(mnem, "cmp") == 0 || strcmp(mnem, "test") == 0) st->loads++;
+            else { st->loads++; st->stores++; }
+        }
+        if (src_mem) st->loads++;
+    }
+}
+
+// ----------------------------------------------------------
+// Compile one program under one config
+// ----------------------------------------------------------
+
+// What --run saw for one program under one config
+typedef struct {
+    bool ok;                // the IR ran without faulting
+    long long result;
+    long dyn_ops;           // IR ops executed
+    X86Status exec;         // the emitted assembly
+    long long exec_result;
+    char error[192];        // X86_BROKEN: why
+} RunResult;
+
+static void compile_program(const char* src, const Config* cfg, AsmStats* st, RunResult* run) {
+    PassManager pm;
+    pm_init(&pm);
+    if (!pm_parse_option(&pm, cfg->passes)) {
+        fprintf(stderr, "Error: config %s: bad pass option %s\n", cfg->name, cfg->passes);
+        exit(1);
+    }
+    g_symstack = symstack_new(NULL);
+
+    Parser parser;
+    init_parser(&parser, src, NULL);
+    Program* prog = parse_program(&parser);
+    pm_run_program(&pm, prog);
+
+    int n = prog->count;
+    const char** names = malloc(sizeof(char*) * (n + 1));
+    int* params = malloc(sizeof(int) * (n + 1));
+    IRList* irs = malloc(sizeof(IRList) * (n + 1));
+    IRFunction* fns = malloc(sizeof(IRFunction) * (n + 1));
+    int* frames = malloc(sizeof(int) * (n + 1));
+    for (int i = 0; i < n; i++) {
+        names[i] = prog->fns[i]->name;
+        params[i] = prog->fns[i]->param_count;
+    }
+    gen_set_callees(names, params, n);
+    stack_machine_set_callees(names, n);
+    stack_machine_set_regalloc(cfg->regalloc);
+    stack_machine_set_size_opt(cfg->size_opt);
+    long bytes_before = stack_machine_code_bytes();
+
+    char* text = NULL;
+    size_t len = 0;
+    FILE* out = open_memstream(&text, &len);
+    for (int i = 0; i < n; i++) {
+        ir_init(&irs[i], NULL);
+        gen_function(prog->fns[i], &irs[i], &frames[i]);
+        pm_run_ir(&pm, names[i], &irs[i], &frames[i]);  // verifies codegen and every IR pass
+        stack_machine_emit(out, names[i], &irs[i], frames[i]);
+        fns[i] = (IRFunction){ &irs[i], frames[i] };
+    }
+    fclose(out);
+    count_asm(text, st);
+    st->bytes = stack_machine_code_bytes() - bytes_before;
+
+    if (run) {
+        long counts[IR_OP_COUNT] = {0};
+        int entry = program_find_function(prog, "main");
+        run->ok = ir_interpret_call(fns, n, entry, NULL, 0, &run->result, counts);
+        run->dyn_ops = 0;
+        for (int i = 0; i < IR_OP_COUNT; i++) {
+            if (i != IR_LINE && i != IR_LABEL) run->dyn_ops += counts[i];  // markers emit no code
+        }
+
+        X86Program x86;
+        run->exec = X86_BROKEN;
+        if (!x86_load(&x86, text)) {
+            snprintf(run->error, sizeof run->error, "%s", x86.error);
+        } else if (find_label(&x86, "main") < 0) {
+            snprintf(run->error, sizeof run->error, "no main in the assembly");
+        } else {
+            run->exec = x86_run(&x86, find_label(&x86, "main"), &run->exec_result,
+                                run->error, sizeof run->error);
+        }
+        x86_free(&x86);
+    }
+    free(text);
+
+    for (int i = 0; i < n; i++) ir_free(&irs[i]);
+    free(irs);
+    free(fns);
+    free(frames);
+    free(params);
+    free(names);
+    free_program(prog);
+    free_parser(&parser);
+    symstack_free(g_symstack);
+}
+
+// ----------------------------------------------------------
+// Baseline
+// ----------------------------------------------------------
+
+static int load_baseline(const char* path, Row* rows) {
+    FILE* f = fopen(path, "r");
+    if (!f) return 0;
+    int n = 0;
+    char line[256];
+    while (n < MAX_ROWS && fgets(line, sizeof line, f)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        Row* r = &rows[n];
+        if (sscanf(line, "%63s %15s %ld %ld %ld %ld %ld %ld %ld", r->program, r->config,
+                   &r->s.insns, &r->s.pushes, &r->s.pops, &r->s.loads, &r->s.stores, &r->s.idivs,
+                   &r->s.bytes) == 9)
+            n++;
+    }
+    fclose(f);
+    return n;
+}
+
+static bool save_baseline(const char* path, const Row* rows, int n) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "# program config insns push pop loads stores idiv bytes\n");
+    for (int i = 0; i < n; i++) {
+        const AsmStats* s = &rows[i].s;
+        fprintf(f, "%s %s %ld %ld %ld %ld %ld %ld %ld\n", rows[i].program, rows[i].config,
+                s->insns, s->pushes, s->pops, s->loads, s->stores, s->idivs, s->bytes);
+    }
+    return fclose(f) == 0;
+}
+
+static const Row* find_row(const Row* rows, int n, const char* program, const char* config) {
+    for (int i = 0; i < n; i++) {
+        if (strcmp(rows[i].program, program) == 0 && strcmp(rows[i].config, config) == 0)
+            return &rows[i];
+    }
+    return NULL;
+}
+
+// ----------------------------------------------------------
+// Driver
+// ----------------------------------------------------------
+
+int main(int argc, char** argv) {
+    bool run = false, update = false;
+    const char* baseline_path = "bench/codegen_quality.baseline";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--run") == 0) run = true;
+        else if (strcmp(argv[i], "--update") == 0) update = true;
+        else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) baseline_path = argv[++i];
+        else {
+            fprintf(stderr, "Usage: %s [--run] [--update] [--baseline FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    struct { const char* name; char* src; } corpus[] = {
+        { "main.jive",  read_file("main.jive") },
+        { "chain_200",  gen_chain(200) },
+        { "wide_100",   gen_wide(100) },
+        { "divmod_50",  gen_divmod(50) },
+        { "calls_100",  gen_calls(100) },
+        { "loop_1000",  gen_loop(1000) },
+        { "scopes_50",  gen_scopes(50) },
+    };
+    int corpus_count = (int)(sizeof corpus / sizeof corpus[0]);
+
+    Row rows[MAX_ROWS], base[MAX_ROWS];
+    int nrows = 0;
+    int nbase = update ? 0 : load_baseline(baseline_path, base);
+    bool regressed = false, mismatch = false;
+
+    printf("%-12s %-8s %7s %6s %6s %6s %6s %5s %6s", "program", "config",
+           "insns", "push", "pop", "loads", "stores", "idiv", "bytes");
+    if (run) printf(" %9s %12s %12s", "dyn-ir", "result", "x86");
+    printf("\n");
+
+    for (int p = 0; p < corpus_count; p++) {
+        if (!corpus[p].src) {
+            fprintf(stderr, "warning: cannot read %s (run from the repo root)\n", corpus[p].name);
+            continue;
+        }
+        // a fault is an outcome too: every config must agree on it
+        long long first_result = 0;
+        bool first_ok = false, any_ok = false;
+        for (int c = 0; c < CONFIG_COUNT; c++) {
+            Row* r = &rows[nrows++];
+            snprintf(r->program, sizeof r->program, "%s", corpus[p].name);
+            snprintf(r->config, sizeof r->config, "%s", configs[c].name);
+
+            RunResult res = {0};
+            compile_program(corpus[p].src, &configs[c], &r->s, run ? &res : NULL);
+
+            printf("%-12s %-8s %7ld %6ld %6ld %6ld %6ld %5ld %6ld", r->program, r->config, r->s.insns,
+                   r->s.pushes, r->s.pops, r->s.loads, r->s.stores, r->s.idivs, r->s.bytes);
+            if (run) {
+                if (res.ok) printf(" %9ld %12lld", res.dyn_ops, res.result);
+                else printf(" %9s %12s", "-", "fault");
+                // the assembly must do what its IR does
+                if (res.exec == X86_BROKEN) {
+                    printf(" %12s", "BROKEN");
+                    fprintf(stderr, "Error: %s/%s: %s\n", r->program, r->config, res.error);
+                    mismatch = true;
+                } else {
+                    if (res.exec == X86_OK) printf(" %12lld", res.exec_result);
+                    else printf(" %12s", "fault");
+                    if ((res.exec == X86_OK) != res.ok || (res.ok && res.exec_result != res.result)) {
+                        printf("  EXEC MISMATCH");
+                        mismatch = true;
+                    }
+                }
+                if (c == 0) {
+                    first_result = res.result;
+                    first_ok = res.ok;
+                } else if (res.ok != first_ok || (res.ok && res.result != first_result)) {
+                    mismatch = true;
+                }
+                any_ok |= res.ok;
+            }
+
+            const Row* b = find_row(base, nbase, r->program, r->config);
+            if (b) {
+                long d = r->s.insns - b->s.insns;
+                if (d) printf("  (%+ld insns vs baseline)", d);
+                if (r->s.insns > b->s.insns || r->s.pushes > b->s.pushes || r->s.pops > b->s.pops ||
+                    r->s.loads > b->s.loads || r->s.stores > b->s.stores || r->s.idivs > b->s.idivs ||
+                    r->s.bytes > b->s.bytes) {
+                    printf("  REGRESSED");
+                    regressed = true;
+                }
+            }
+            printf("\n");
+        }
+        if (run && !any_ok) {
+            fprintf(stderr, "Error: %s faults under every config\n", corpus[p].name);
+            mismatch = true;
+        }
+        free(corpus[p].src);
+    }
+
+    if (update) {
+        if (!save_baseline(baseline_path, rows, nrows)) {
+            fprintf(stderr, "Error: cannot write %s\n", baseline_path);
+            return 1;
+        }
+        printf("Baseline written: %s\n", baseline_path);
+    }
+    if (mismatch) fprintf(stderr, "Error: configs or their assembly disagree on program results\n");
+    return (regressed || mismatch) ? 1 : 0;
+}
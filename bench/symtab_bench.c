@@ -0,0 +1,280 @@
+// ==========================================================
+// Symbol table microbenchmark
+//
+// Times insert_symbol / lookup_symbol on a bare Symbol_Table and
+// symstack_declare / symstack_lookup through the scope stack, for
+// 10 .. 1M symbols and three identifier distributions:
+//   short   a, b, ..., z, ba, bb, ...     (base-26, like hand-written code)
+//   long    24-40 pseudo-random letters
+//   prefix  tmp_000000, tmp_000001, ...   (generated temporaries)
+// For each table it reports ns/op, rehash count, the bucket chain-length
+// histogram and the probe-length histogram of successful lookups
+// (names compared, the hit included), so hash and layout changes can be
+// judged from data. A second section varies scope depth.
+//
+// Build (from the repo root):
+//   gcc -O2 -I. -o symtab_bench bench/symtab_bench.c alloc.c symbol_table.c
+// Run:
+//   ./symtab_bench [--max N] [--dist short|long|prefix]
+// ==========================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "symbol_table.h"
+
+#define HIST_BUCKETS 9   // 0..7, then 8+
+#define MAX_DEPTH 64
+
+typedef enum { DIST_SHORT, DIST_LONG, DIST_PREFIX, DIST_COUNT } Dist;
+static const char* const dist_names[DIST_COUNT] = { "short", "long", "prefix" };
+
+// ----------------------------------------------------------
+// Helpers
+// ----------------------------------------------------------
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned long long rng_state = 0x9e3779b97f4a7c15ULL;
+
+static unsigned long long rng_next(void) {
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545f4914f6cdd1dULL;
+}
+
+// Name #i of a distribution; distinct for distinct i
+static char* make_name(Dist d, long i) {
+    char buf[64];
+    switch (d) {
+        case DIST_SHORT: {
+            char rev[16];
+            int n = 0;
+            long v = i;
+            do {
+                rev[n++] = (char)('a' + v % 26);
+                v /= 26;
+            } while (v);
+            for (int k = 0; k < n; k++) buf[k] = rev[n - 1 - k];
+            buf[n] = '\0';
+            break;
+        }
+        case DIST_LONG: {
+            // random letters, with the index as a unique suffix
+            int len = 24 + (int)(rng_next() % 10);
+            for (int k = 0; k < len; k++) buf[k] = (char)('a' + rng_next() % 26);
+            snprintf(buf + len, sizeof buf - len, "%ld", i);
+            break;
+        }
+        default:
+            snprintf(buf, sizeof buf, "tmp_%06ld", i);
+            break;
+    }
+    return strdup(buf);
+}
+
+static char** make_names(Dist d, long n) {
+    char** names = malloc(sizeof(char*) * n);
+    for (long i = 0; i < n; i++) names[i] = make_name(d, i);
+    return names;
+}
+
+static void free_names(char** names, long n) {
+    for (long i = 0; i < n; i++) free(names[i]);
+    free(names);
+}
+
+// Lookup order: a shuffled permutation of 0..n-1
+static long* make_order(long n) {
+    long* order = malloc(sizeof(long) * n);
+    for (long i = 0; i < n; i++) order[i] = i;
+    for (long i = n - 1; i > 0; i--) {
+        long j = (long)(rng_next() % (unsigned long long)(i + 1));
+        long t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+    return order;
+}
+
+static void hist_add(long* hist, long value) {
+    hist[value < HIST_BUCKETS - 1 ? value : HIST_BUCKETS - 1]++;
+}
+
+static void hist_print(const char* label, const long* hist) {
+    long total = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) total += hist[i];
+    printf("    %-7s", label);
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        printf(" %s%d:%5.1f%%", i == HIST_BUCKETS - 1 ? ">=" : "", i,
+               total ? 100.0 * hist[i] / total : 0.0);
+    }
+    printf("\n");
+}
+
+// ----------------------------------------------------------
+// Hash quality of a filled table
+// ----------------------------------------------------------
+
+typedef struct {
+    long chain_hist[HIST_BUCKETS];
+    long probe_hist[HIST_BUCKETS];
+    long max_chain;
+    double avg_probe;
+} TableStats;
+
+static void table_stats(const Symbol_Table* t, TableStats* st) {
+    memset(st, 0, sizeof *st);
+    long probes = 0, entries = 0;
+    for (long b = 0; b < t->number_of_slots; b++) {
+        long len = 0;
+        for (Symbol* s = t->symbols[b]; s; s = s->next) {
+            len++;
+            hist_add(st->probe_hist, len);  // a hit at position len compares len names
+            probes += len;
+            entries++;
+        }
+        hist_add(st->chain_hist, len);
+        if (len > st->max_chain) st->max_chain = len;
+    }
+    st->avg_probe = entries ? (double)probes / entries : 0.0;
+}
+
+// ----------------------------------------------------------
+// Benchmarks
+// ----------------------------------------------------------
+
+static volatile long sink;
+
+// insert_symbol / lookup_symbol on one table, starting at 16 slots
+// like the table behind SymStack
+static void bench_table(Dist d, long n) {
+    char** names = make_names(d, n);
+    long miss_count = n / 4 ? n / 4 : 1;
+    char** misses = malloc(sizeof(char*) * miss_count);  // names never inserted
+    for (long i = 0; i < miss_count; i++) misses[i] = make_name(d, n + i);
+    long* order = make_order(n);
+
+    Symbol_Table t = make_symbol_table(16);
+    double t0 = now_ns();
+    for (long i = 0; i < n; i++) insert_symbol(&t, names[i], (Symbol_Data){ (int)i });
+    double t1 = now_ns();
+
+    long found = 0;
+    for (long i = 0; i < n; i++) found += lookup_symbol(&t, names[order[i]]) != NULL;
+    double t2 = now_ns();
+
+    for (long i = 0; i < miss_count; i++) found += lookup_symbol(&t, misses[i]) != NULL;
+    double t3 = now_ns();
+    sink = found;
+
+    TableStats st;
+    table_stats(&t, &st);
+    printf("%-7s %8ld %10.1f %10.1f %10.1f %7ld %9ld %6.2f %6ld %6.2f\n",
+           dist_names[d], n, (t1 - t0) / n, (t2 - t1) / n, (t3 - t2) / miss_count,
+           t.grow_count, t.number_of_slots, (double)t.entry_count / t.number_of_slots,
+           st.max_chain, st.avg_probe);
+    if (n >= 1000) {
+        hist_print("chains", st.chain_hist);
+        hist_print("probes", st.probe_hist);
+    }
+
+    free_symbol_table(&t);
+    free(order);
+    free_names(misses, miss_count);
+    free_names(names, n);
+}
+
+// symstack_declare / symstack_lookup with n names spread evenly over
+// `depth` nested scopes; every lookup is one probe of the shared table,
+// so depth should not show in the lookup time
+static void bench_scopes(Dist d, long n, int depth) {
+    char** names = make_names(d, n);
+    long* order = make_order(n);
+    SymStack* s = symstack_new(NULL);
+
+    double t0 = now_ns();
+    long per_scope = (n + depth - 1) / depth;
+    for (long i = 0; i < n; i++) {
+        if (i % per_scope == 0) symstack_push_scope(s);
+        int offset;
+        symstack_declare(s, names[i], &offset);
+    }
+    double t1 = now_ns();
+
+    long found = 0;
+    for (long i = 0; i < n; i++) found += symstack_lookup(s, names[order[i]]) != NULL;
+    double t2 = now_ns();
+    sink = found;
+
+    // Probe length: entries compared in the name's bucket
+    long probes = 0, rehash = s->table.grow_count;
+    long probe_hist[HIST_BUCKETS] = {0};
+    for (long i = 0; i < n; i++) {
+        long p = 0;
+        Symbol* sym = s->table.symbols[symbol_hash(names[i]) % s->table.number_of_slots];
+        for (; sym; sym = sym->next) {
+            p++;
+            if (strcmp(sym->name, names[i]) == 0) break;
+        }
+        probes += p;
+        hist_add(probe_hist, p);
+    }
+
+    printf("%-7s %8ld %6d %10.1f %10.1f %7ld %6.2f\n", dist_names[d], n, s->depth,
+           (t1 - t0) / n, (t2 - t1) / n, rehash, (double)probes / n);
+    hist_print("probes", probe_hist);
+
+    symstack_free(s);
+    free(order);
+    free_names(names, n);
+}
+
+// ----------------------------------------------------------
+// Driver
+// ----------------------------------------------------------
+
+int main(int argc, char** argv) {
+    long max_n = 1000000;
+    int only = -1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max") == 0 && i + 1 < argc) {
+            max_n = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--dist") == 0 && i + 1 < argc) {
+            i++;
+            for (int d = 0; d < DIST_COUNT; d++) {
+                if (strcmp(argv[i], dist_names[d]) == 0) only = d;
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [--max N] [--dist short|long|prefix]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("== Symbol_Table: insert_symbol / lookup_symbol (ns/op) ==\n");
+    printf("%-7s %8s %10s %10s %10s %7s %9s %6s %6s %6s\n", "dist", "symbols",
+           "insert", "hit", "miss", "rehash", "slots", "load", "chain", "probe");
+    for (int d = 0; d < DIST_COUNT; d++) {
+        if (only >= 0 && d != only) continue;
+        for (long n = 10; n <= max_n; n *= 10) bench_table((Dist)d, n);
+    }
+
+    printf("\n== SymStack: symstack_declare / symstack_lookup (ns/op) ==\n");
+    printf("%-7s %8s %6s %10s %10s %7s %6s\n", "dist", "symbols", "scopes",
+           "declare", "lookup", "rehash", "probe");
+    static const int depths[] = { 1, 4, 16, MAX_DEPTH };
+    long n = max_n < 10000 ? max_n : 10000;
+    for (int d = 0; d < DIST_COUNT; d++) {
+        if (only >= 0 && d != only) continue;
+        for (int k = 0; k < (int)(sizeof depths / sizeof depths[0]); k++) {
+            if (depths[k] <= n) bench_scopes((Dist)d, n, depths[k]);
+        }
+    }
+    return 0;
+}
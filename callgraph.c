@@ -0,0 +1,119 @@
+#include "callgraph.h"
+#include "symbol_table.h"
+#include <stdio.h>
+#include <string.h>
+
+int program_find_function(const Program* prog, const char* name) {
+    for (int i = 0; i < prog->count; i++) {
+        if (strcmp(prog->fns[i]->name, name) == 0) return i;
+    }
+    return -1;
+}
+
+// ----------------------------------------------------------
+// Worklist over call expressions
+// ----------------------------------------------------------
+
+typedef struct {
+    Symbol_Table by_name;   // function name -> index (variable_slot)
+    bool* live;
+    int* worklist;
+    int pending;
+} Reach;
+
+static void mark(Reach* r, int index) {
+    if (index < 0 || r->live[index]) return;
+    r->live[index] = true;
+    r->worklist[r->pending++] = index;
+}
+
+static void scan_expr(Reach* r, Expr* e) {
+    if (!e) return;
+    switch (e->kind) {
+        case EXPR_BINOP:
+            scan_expr(r, e->bin.lhs);
+            scan_expr(r, e->bin.rhs);
+            break;
+
+        case EXPR_CALL: {
+            Symbol_Data* d = lookup_symbol(&r->by_name, e->call.name);
+            if (d) mark(r, d->variable_slot);
+            for (int i = 0; i < e->call.argc; i++) scan_expr(r, e->call.args[i]);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+static void scan_block(Reach* r, const Block* b);
+
+static void scan_stmt(Reach* r, Stmt* s) {
+    switch (s->kind) {
+        case STMT_LET:    scan_expr(r, s->let_.init); break;
+        case STMT_SET:    scan_expr(r, s->set_.expr); break;
+        case STMT_RETURN: scan_expr(r, s->ret_.expr); break;
+        case STMT_IF:
+            scan_expr(r, s->if_.cond);
+            scan_block(r, &s->if_.then_);
+            scan_block(r, &s->if_.else_);
+            break;
+        case STMT_WHILE:
+            scan_expr(r, s->while_.cond);
+            scan_block(r, &s->while_.body);
+            break;
+        case STMT_BLOCK:
+            scan_block(r, &s->block_);
+            break;
+    }
+}
+
+static void scan_block(Reach* r, const Block* b) {
+    for (int k = 0; k < b->count; k++) scan_stmt(r, b->stmts[k]);
+}
+
+int eliminate_dead_functions(Program* prog) {
+    Reach r;
+    r.by_name = make_symbol_table_with(prog->A, 64);
+    r.live = mem_alloc(prog->A, sizeof(bool) * (prog->count + 1));
+    r.worklist = mem_alloc(prog->A, sizeof(int) * (prog->count + 1));
+    r.pending = 0;
+
+    for (int i = 0; i < prog->count; i++) {
+        Symbol_Data d = { .variable_slot = i };
+        if (!insert_symbol(&r.by_name, prog->fns[i]->name, d)) {
+            fprintf(stderr, "Error: function '%s' defined twice\n", prog->fns[i]->name);
+            exit(1);
+        }
+    }
+
+    // ---- Roots ----
+    for (int i = 0; i < prog->count; i++) {
+        Function* fn = prog->fns[i];
+        if (fn->exported || strcmp(fn->name, "main") == 0) mark(&r, i);
+    }
+
+    // ---- Propagate through call expressions ----
+    while (r.pending > 0) {
+        Function* fn = prog->fns[r.worklist[--r.pending]];
+        for (int k = 0; k < fn->stmt_count; k++) scan_stmt(&r, fn->stmts[k]);
+    }
+
+    // ---- Compact, keeping definition order ----
+    int n = 0, removed = 0;
+    for (int i = 0; i < prog->count; i++) {
+        if (r.live[i]) {
+            prog->fns[n++] = prog->fns[i];
+        } else {
+            free_function(prog->fns[i]);
+            removed++;
+        }
+    }
+    prog->count = n;
+
+    free_symbol_table(&r.by_name);
+    mem_free(prog->A, r.live);
+    mem_free(prog->A, r.worklist);
+    return removed;
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "parser.h"
+
+// Dead-function elimination over the call graph.
+// Roots are `export fn` functions and `main`; every function not
+// reachable from a root through call expressions is removed from the
+// program (and freed). Returns the number of functions removed.
+int eliminate_dead_functions(Program* prog);
+
+// Index of the function called `name`, or -1.
+int program_find_function(const Program* prog, const char* name);
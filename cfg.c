@@ -0,0 +1,119 @@
+#include "cfg.h"
+#include <stdlib.h>
+#include <string.h>
+
+static bool ends_block(IROp op) {
+    return op == IR_JMP || op == IR_JZ || op == IR_RET;
+}
+
+// ----------------------------------------------------------
+// Blocks and edges
+// ----------------------------------------------------------
+
+void cfg_build(CFG* g, const IRList* ir) {
+    memset(g, 0, sizeof *g);
+    g->A = ir->A;
+    for (int i = 0; i < ir->count; i++) {
+        if (ir->code[i].op == IR_LABEL && ir->code[i].imm >= g->label_count)
+            g->label_count = ir->code[i].imm + 1;
+    }
+
+    // ---- Leaders ----
+    bool* leader = mem_alloc(g->A, sizeof(bool) * (ir->count + 1));
+    int n = 0;
+    for (int i = 0; i < ir->count; i++) {
+        if (i == 0 || ir->code[i].op == IR_LABEL || ends_block(ir->code[i - 1].op)) {
+            leader[i] = true;
+            n++;
+        }
+    }
+
+    g->blocks = mem_alloc(g->A, sizeof(BasicBlock) * (n + 1));
+    g->label_block = mem_alloc(g->A, sizeof(int) * (g->label_count + 1));
+    for (int l = 0; l < g->label_count; l++) g->label_block[l] = -1;
+
+    for (int i = 0; i < ir->count; i++) {
+        if (!leader[i]) continue;
+        if (g->count > 0) g->blocks[g->count - 1].end = i;
+        BasicBlock* b = &g->blocks[g->count++];
+        b->start = i;
+        b->end = ir->count;
+        b->label = ir->code[i].op == IR_LABEL ? ir->code[i].imm : -1;
+        b->nsucc = 0;
+        if (b->label >= 0) g->label_block[b->label] = g->count - 1;
+    }
+    mem_free(g->A, leader);
+
+    // ---- Successors ----
+    for (int k = 0; k < g->count; k++) {
+        BasicBlock* b = &g->blocks[k];
+        IR last = ir->code[b->end - 1];
+        bool falls = last.op != IR_JMP && last.op != IR_RET;
+        if (falls && k + 1 < g->count) b->succ[b->nsucc++] = k + 1;
+        if (last.op == IR_JMP || last.op == IR_JZ) b->succ[b->nsucc++] = g->label_block[last.imm];
+    }
+}
+
+void cfg_free(CFG* g) {
+    mem_free(g->A, g->blocks);
+    mem_free(g->A, g->label_block);
+    memset(g, 0, sizeof *g);
+}
+
+// ----------------------------------------------------------
+// Natural loops
+// ----------------------------------------------------------
+
+Loop* cfg_find_loops(const CFG* g, int* out_count) {
+    Loop* loops = NULL;
+    int count = 0, cap = 0;
+    int* work = mem_alloc(g->A, sizeof(int) * (g->count + 1));
+
+    for (int k = 0; k < g->count; k++) {
+        const BasicBlock* b = &g->blocks[k];
+        for (int s = 0; s < b->nsucc; s++) {
+            int h = b->succ[s];
+            if (h < 0 || h > k) continue;  // not a back edge
+
+            if (count == cap) {
+                cap = (cap == 0) ? 4 : cap * 2;
+                loops = mem_realloc(g->A, loops, sizeof(Loop) * cap);
+            }
+            Loop* L = &loops[count++];
+            L->header = h;
+            L->latch = k;
+            L->body = mem_alloc(g->A, sizeof(bool) * (g->count + 1));
+            L->body[h] = true;
+
+            // Walk predecessors backwards from the latch, stopping at the header
+            int pending = 0;
+            if (!L->body[k]) {
+                L->body[k] = true;
+                work[pending++] = k;
+            }
+            while (pending > 0) {
+                int x = work[--pending];
+                for (int p = 0; p < g->count; p++) {
+                    if (L->body[p]) continue;
+                    const BasicBlock* pb = &g->blocks[p];
+                    for (int t = 0; t < pb->nsucc; t++) {
+                        if (pb->succ[t] == x) {
+                            L->body[p] = true;
+                            work[pending++] = p;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    mem_free(g->A, work);
+    *out_count = count;
+    return loops;
+}
+
+void cfg_free_loops(const CFG* g, Loop* loops, int count) {
+    for (int i = 0; i < count; i++) mem_free(g->A, loops[i].body);
+    mem_free(g->A, loops);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "stack_machine_ir.h"
+
+// Control-flow graph over one function's IR.
+// A basic block is the index range [start, end) of the IRList: leaders
+// are the first instruction, every IR_LABEL and every instruction after
+// IR_JMP / IR_JZ / IR_RET. The last instruction of a block is its
+// terminator when it is a jump or return; otherwise control falls
+// through to the next block. Codegen leaves the operand stack empty at
+// every block boundary.
+typedef struct {
+    int start;
+    int end;
+    int label;    // IR_LABEL at start, or -1
+    int succ[2];  // successor block indices (fall-through first)
+    int nsucc;
+} BasicBlock;
+
+typedef struct {
+    BasicBlock* blocks;
+    int count;
+    int* label_block;  // label -> block index
+    int label_count;   // labels are 0 .. label_count-1
+    Allocator* A;      // the IRList's; also used for the loops found in g
+} CFG;
+
+// A natural loop: the header and every block that reaches the latch
+// (the source of the back edge) without passing through the header.
+typedef struct {
+    int header;   // block index
+    int latch;    // block index ending in the back edge
+    bool* body;   // per block: member of the loop
+} Loop;
+
+void cfg_build(CFG* g, const IRList* ir);
+void cfg_free(CFG* g);
+
+// All natural loops, one per back edge (an edge to a block at or before
+// its source). Caller frees with cfg_free_loops, before cfg_free.
+Loop* cfg_find_loops(const CFG* g, int* out_count);
+void cfg_free_loops(const CFG* g, Loop* loops, int count);
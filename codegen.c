@@ -7,8 +7,119 @@
 // Global symbol stack (should be passed in, but for simplicity...)
 extern SymStack* g_symstack;
 
+// Call targets of the module being compiled
+static const char* const* g_callee_names = NULL;
+static const int* g_callee_params = NULL;
+static int g_callee_count = 0;
+
+void gen_set_callees(const char* const* names, const int* param_counts, int count) {
+    g_callee_names = names;
+    g_callee_params = param_counts;
+    g_callee_count = count;
+}
+
+// Resolve a call target and check its arity; returns the module index
+static int resolve_callee(const char* name, int argc) {
+    for (int i = 0; i < g_callee_count; i++) {
+        if (strcmp(g_callee_names[i], name) != 0) continue;
+        if (g_callee_params[i] != argc) {
+            fprintf(stderr, "Error: '%s' expects %d argument(s), got %d\n",
+                    name, g_callee_params[i], argc);
+            exit(1);
+        }
+        return i;
+    }
+    fprintf(stderr, "Error: call to undefined function '%s'\n", name);
+    exit(1);
+}
+
+// Outgoing arguments are on the operand stack, last on top: pop each
+// into its SysV register (last first), then call.
+static void gen_call(IRList* ir, const char* name, int argc) {
+    int index = resolve_callee(name, argc);
+    for (int i = argc - 1; i >= 0; i--) ir_emit(ir, IR_ARG, i);
+    ir_emit(ir, IR_CALL, index);
+}
+
+// Spill incoming parameter #index to its frame slot
+static void gen_param(IRList* ir, const char* name, int index) {
+    int offset;
+    if (!symstack_declare(g_symstack, name, &offset)) {
+        fprintf(stderr, "Error: parameter '%s' already declared\n", name);
+        exit(1);
+    }
+    ir_emit(ir, IR_PARAM, index);
+    ir_emit(ir, IR_STORE, offset);
+}
+
+// Jump labels are numbered per function (NASM local labels .L<n>)
+static int g_label_count = 0;
+
+static int new_label(void) {
+    return g_label_count++;
+}
+
+// ========== Sethi-Ullman labels ==========
+// su_need: operand-stack slots needed to evaluate e when the heavier
+// operand of each binop goes first. Call arguments stay in order, and a
+// subtree with a call is never moved across its sibling, because the
+// call may fault or not return.
+static int su_label(Expr* e) {
+    switch (e->kind) {
+        case EXPR_BINOP: {
+            int l = su_label(e->bin.lhs);
+            int r = su_label(e->bin.rhs);
+            e->su_call = e->bin.lhs->su_call || e->bin.rhs->su_call;
+            if (e->su_call) e->su_need = (l > r + 1) ? l : r + 1;
+            else e->su_need = (l == r) ? l + 1 : (l > r ? l : r);
+            break;
+        }
+        case EXPR_CALL:
+            e->su_call = true;
+            e->su_need = 1;
+            for (int i = 0; i < e->call.argc; i++) {
+                int need = i + su_label(e->call.args[i]);
+                if (need > e->su_need) e->su_need = need;
+            }
+            break;
+        default:
+            e->su_call = false;
+            e->su_need = 1;
+            break;
+    }
+    return e->su_need;
+}
+
 // ========== Generate IR for expressions ==========
+static void gen_labeled(IRList* ir, Expr* e);
+
+// rev: the operands were pushed rhs first, so lhs is on top
+static IROp binop_ir(TokenType op, bool rev) {
+    switch (op) {
+        case T_PLUS:    return IR_ADD;
+        case T_MINUS:   return rev ? IR_SUB_R : IR_SUB;
+        case T_STAR:    return IR_MUL;
+        case T_SLASH:   return rev ? IR_DIV_R : IR_DIV;
+        case T_PERCENT: return rev ? IR_MOD_R : IR_MOD;
+        // a < b is b > a once the operands are swapped
+        case T_LESS:          return rev ? IR_GT : IR_LT;
+        case T_LESS_EQUAL:    return rev ? IR_GE : IR_LE;
+        case T_GREATER:       return rev ? IR_LT : IR_GT;
+        case T_GREATER_EQUAL: return rev ? IR_LE : IR_GE;
+        case T_EQUAL_EQUAL:   return IR_EQ;
+        case T_BANG_EQUAL:    return IR_NE;
+        default:
+            fprintf(stderr, "Unknown operator in binary expression.\n");
+            exit(1);
+    }
+}
+
 void gen_expr(IRList* ir, Expr* e) {
+    su_label(e);
+    gen_labeled(ir, e);
+}
+
+static void gen_labeled(IRList* ir, Expr* e) {
     switch (e->kind) {
         case EXPR_INT:
             ir_emit(ir, IR_PUSH_INT, e->int_value);
@@ -23,24 +134,22 @@ void gen_expr(IRList* ir, Expr* e) {
             }
             // Generate LOAD instruction with the variable's offset
             ir_emit(ir, IR_LOAD, sym->offset);
-            free(sym);  // symstack_lookup allocates, so we free
             break;
         }
 
-        case EXPR_BINOP:
-            gen_expr(ir, e->bin.lhs);
-            gen_expr(ir, e->bin.rhs);
-
-            switch (e->bin.op) {
-                case T_PLUS:    ir_emit(ir, IR_ADD, 0); break;
-                case T_MINUS:   ir_emit(ir, IR_SUB, 0); break;
-                case T_STAR:    ir_emit(ir, IR_MUL, 0); break;
-                case T_SLASH:   ir_emit(ir, IR_DIV, 0); break;
-                case T_PERCENT: ir_emit(ir, IR_MOD, 0); break;
-                default:
-                    fprintf(stderr, "Unknown operator in binary expression.\n");
-                    exit(1);
-            }
+        case EXPR_BINOP: {
+            // Heavier operand first; the reversed ops take lhs from the top
+            bool rev = !e->su_call && e->bin.rhs->su_need > e->bin.lhs->su_need;
+            gen_labeled(ir, rev ? e->bin.rhs : e->bin.lhs);
+            gen_labeled(ir, rev ? e->bin.lhs : e->bin.rhs);
+
+            ir_emit(ir, binop_ir(e->bin.op, rev), 0);
+            break;
+        }
+
+        case EXPR_CALL:
+            for (int i = 0; i < e->call.argc; i++) gen_labeled(ir, e->call.args[i]);
+            gen_call(ir, e->call.name, e->call.argc);
             break;
 
         default:
@@ -50,20 +159,31 @@ void gen_expr(IRList* ir, Expr* e) {
 }
 
 // ========== Generate IR for statements ==========
+void gen_stmt(IRList* ir, Stmt* s);
+
+// A body is a scope: its lets shadow outer names and give their frame
+// slots back when it ends
+static void gen_block(IRList* ir, const Block* b) {
+    symstack_push_scope(g_symstack);
+    for (int i = 0; i < b->count; i++) gen_stmt(ir, b->stmts[i]);
+    symstack_pop_scope(g_symstack);
+}
+
 void gen_stmt(IRList* ir, Stmt* s) {
+    // a loop places its line marker at the head, so it counts condition
+    // tests; a bare block has no code of its own
+    if (s->kind != STMT_WHILE && s->kind != STMT_BLOCK) ir_emit(ir, IR_LINE, s->line);
     switch (s->kind) {
         case STMT_LET: {
-            // Declare variable in symbol table
+            // The initializer is evaluated before the name is declared,
+            // so `let x = x + 1` reads the x it shadows
+            if (s->let_.init) gen_expr(ir, s->let_.init);
             int offset;
             if (!symstack_declare(g_symstack, s->let_.name, &offset)) {
                 fprintf(stderr, "Error: variable '%s' already declared\n", s->let_.name);
                 exit(1);
             }
-            // If there's an initializer, generate code and store
-            if (s->let_.init) {
-                gen_expr(ir, s->let_.init);
-                ir_emit(ir, IR_STORE, offset);
-            }
+            if (s->let_.init) ir_emit(ir, IR_STORE, offset);
             break;
         }
 
@@ -77,7 +197,6 @@ void gen_stmt(IRList* ir, Stmt* s) {
             // Generate expression and store to variable
             gen_expr(ir, s->set_.expr);
             ir_emit(ir, IR_STORE, sym->offset);
-            free(sym);
             break;
         }
 
@@ -86,6 +205,42 @@ void gen_stmt(IRList* ir, Stmt* s) {
             ir_emit(ir, IR_RET, 0);
             break;
 
+        case STMT_IF: {
+            // cond; JZ else; then; [JMP end; else:; else-body;] end:
+            int else_label = new_label();
+            gen_expr(ir, s->if_.cond);
+            ir_emit(ir, IR_JZ, else_label);
+            gen_block(ir, &s->if_.then_);
+            if (s->if_.else_.count > 0) {
+                int end_label = new_label();
+                ir_emit(ir, IR_JMP, end_label);
+                ir_emit(ir, IR_LABEL, else_label);
+                gen_block(ir, &s->if_.else_);
+                ir_emit(ir, IR_LABEL, end_label);
+            } else {
+                ir_emit(ir, IR_LABEL, else_label);
+            }
+            break;
+        }
+
+        case STMT_WHILE: {
+            // head:; cond; JZ end; body; JMP head; end:
+            int head = new_label();
+            int end = new_label();
+            ir_emit(ir, IR_LABEL, head);
+            ir_emit(ir, IR_LINE, s->line);
+            gen_expr(ir, s->while_.cond);
+            ir_emit(ir, IR_JZ, end);
+            gen_block(ir, &s->while_.body);
+            ir_emit(ir, IR_JMP, head);
+            ir_emit(ir, IR_LABEL, end);
+            break;
+        }
+
+        case STMT_BLOCK:
+            gen_block(ir, &s->block_);
+            break;
+
         default:
             fprintf(stderr, "Unknown statement kind.\n");
             exit(1);
@@ -94,8 +249,12 @@ void gen_stmt(IRList* ir, Stmt* s) {
 
 // ========== Generate IR for the whole function ==========
 void gen_function(Function* fn, IRList* ir, int* out_locals_aligned) {
-    // Push a scope for this function
+    // Push a scope for this function (frame slots restart per function)
     symstack_push_scope(g_symstack);
+    symstack_reset_frame(g_symstack);
+    g_label_count = 0;
+    ir_emit(ir, IR_LINE, fn->line);  // function entry
+    for (int i = 0; i < fn->param_count; i++) gen_param(ir, fn->params[i], i);
 
     // Generate code for all statements
     for (int i = 0; i < fn->stmt_count; i++) {
@@ -112,3 +271,190 @@ void gen_function(Function* fn, IRList* ir, int* out_locals_aligned) {
     // Pop the scope
     symstack_pop_scope(g_symstack);
 }
+
+
+// ========== Flat AST: linear post-order walk ==========
+static void label_stmts(Stmt** stmts, int count);
+
+static void label_stmt(Stmt* s) {
+    switch (s->kind) {
+        case STMT_LET:    if (s->let_.init) su_label(s->let_.init); break;
+        case STMT_SET:    su_label(s->set_.expr); break;
+        case STMT_RETURN: su_label(s->ret_.expr); break;
+        case STMT_IF:
+            su_label(s->if_.cond);
+            label_stmts(s->if_.then_.stmts, s->if_.then_.count);
+            label_stmts(s->if_.else_.stmts, s->if_.else_.count);
+            break;
+        case STMT_WHILE:
+            su_label(s->while_.cond);
+            label_stmts(s->while_.body.stmts, s->while_.body.count);
+            break;
+        case STMT_BLOCK:
+            label_stmts(s->block_.stmts, s->block_.count);
+            break;
+    }
+}
+
+static void label_stmts(Stmt** stmts, int count) {
+    for (int i = 0; i < count; i++) label_stmt(stmts[i]);
+}
+
+void gen_flatten_function(Function* fn, FlatAst* out) {
+    label_stmts(fn->stmts, fn->stmt_count);
+    flat_from_function(out, fn);
+}
+
+static void gen_expr_flat(IRList* ir, const FlatAst* a, NodeRef first, NodeRef root) {
+    // Nodes [first, root] are one expression in post-order: emitting
+    // each node in index order yields the operand-stack sequence.
+    for (NodeRef n = first; n <= root; n++) {
+        switch ((ExprKind)a->kind[n]) {
+            case EXPR_INT:
+                ir_emit(ir, IR_PUSH_INT, a->payload[n]);
+                break;
+
+            case EXPR_VAR: {
+                const char* name = a->names[a->payload[n]];
+                Symbol* sym = symstack_lookup(g_symstack, name);
+                if (!sym) {
+                    fprintf(stderr, "Error: undeclared variable '%s'\n", name);
+                    exit(1);
+                }
+                ir_emit(ir, IR_LOAD, sym->offset);
+                break;
+            }
+
+            case EXPR_BINOP:
+                // flat_from_function appends the heavier operand first, so
+                // a right child below the left one means a swapped order
+                ir_emit(ir, binop_ir((TokenType)a->payload[n], a->rhs[n] < a->lhs[n]), 0);
+                break;
+
+            case EXPR_CALL:
+                // arguments are the preceding nodes: already on the stack
+                gen_call(ir, a->names[a->payload[n]], (int)a->rhs[n]);
+                break;
+
+            default:
+                fprintf(stderr, "Unknown expression kind.\n");
+                exit(1);
+        }
+    }
+}
+
+// An if/while/block whose FLAT_END has not been reached yet; each body
+// (and an if's else part) is a symbol scope
+typedef struct {
+    int kind;   // STMT_IF, STMT_WHILE or STMT_BLOCK
+    int head;   // STMT_IF: else label, STMT_WHILE: loop head
+    int end;    // -1 until an if sees FLAT_ELSE
+} OpenBlock;
+
+void gen_function_flat(const FlatAst* a, IRList* ir, int* out_locals_aligned) {
+    symstack_push_scope(g_symstack);
+    symstack_reset_frame(g_symstack);
+    g_label_count = 0;
+    ir_emit(ir, IR_LINE, a->fn_line);  // function entry
+    for (uint32_t i = 0; i < a->param_count; i++)
+        gen_param(ir, a->names[a->extra[a->param_first + i]], (int)i);
+
+    // nesting can be no deeper than the statement count
+    OpenBlock* open = mem_alloc(a->A, sizeof(OpenBlock) * (a->stmt_count + 1));
+    int depth = 0;
+
+    for (uint32_t i = 0; i < a->stmt_count; i++) {
+        NodeRef first = a->stmt_first[i];
+        NodeRef root = a->stmt_root[i];
+        const char* name = a->names[a->stmt_name[i]];
+        int kind = a->stmt_kind[i];
+
+        if (kind == FLAT_ELSE) {
+            OpenBlock* b = &open[depth - 1];
+            symstack_pop_scope(g_symstack);
+            symstack_push_scope(g_symstack);
+            b->end = new_label();
+            ir_emit(ir, IR_JMP, b->end);
+            ir_emit(ir, IR_LABEL, b->head);
+            continue;
+        }
+        if (kind == FLAT_END) {
+            OpenBlock* b = &open[--depth];
+            symstack_pop_scope(g_symstack);
+            if (b->kind == STMT_WHILE) {
+                ir_emit(ir, IR_JMP, b->head);
+                ir_emit(ir, IR_LABEL, b->end);
+            } else if (b->kind == STMT_IF) {
+                ir_emit(ir, IR_LABEL, b->end >= 0 ? b->end : b->head);
+            }
+            continue;
+        }
+        if (kind == STMT_BLOCK) {
+            open[depth++] = (OpenBlock){ STMT_BLOCK, -1, -1 };
+            symstack_push_scope(g_symstack);
+            continue;
+        }
+        if (kind == STMT_WHILE) {
+            OpenBlock* b = &open[depth++];
+            *b = (OpenBlock){ STMT_WHILE, new_label(), new_label() };
+            ir_emit(ir, IR_LABEL, b->head);
+        }
+        ir_emit(ir, IR_LINE, a->stmt_line[i]);
+
+        switch ((StmtKind)kind) {
+            case STMT_LET: {
+                if (root != NODE_NONE) gen_expr_flat(ir, a, first, root);
+                int offset;
+                if (!symstack_declare(g_symstack, name, &offset)) {
+                    fprintf(stderr, "Error: variable '%s' already declared\n", name);
+                    exit(1);
+                }
+                if (root != NODE_NONE) ir_emit(ir, IR_STORE, offset);
+                break;
+            }
+
+            case STMT_SET: {
+                Symbol* sym = symstack_lookup(g_symstack, name);
+                if (!sym) {
+                    fprintf(stderr, "Error: undeclared variable '%s'\n", name);
+                    exit(1);
+                }
+                gen_expr_flat(ir, a, first, root);
+                ir_emit(ir, IR_STORE, sym->offset);
+                break;
+            }
+
+            case STMT_RETURN:
+                gen_expr_flat(ir, a, first, root);
+                ir_emit(ir, IR_RET, 0);
+                break;
+
+            case STMT_IF: {
+                OpenBlock* b = &open[depth++];
+                *b = (OpenBlock){ STMT_IF, new_label(), -1 };
+                gen_expr_flat(ir, a, first, root);
+                ir_emit(ir, IR_JZ, b->head);
+                symstack_push_scope(g_symstack);
+                break;
+            }
+
+            case STMT_WHILE:
+                gen_expr_flat(ir, a, first, root);
+                ir_emit(ir, IR_JZ, open[depth - 1].end);
+                symstack_push_scope(g_symstack);
+                break;
+
+            default:
+                fprintf(stderr, "Unknown statement kind.\n");
+                exit(1);
+        }
+    }
+    mem_free(a->A, open);
+
+    int total_bytes = symstack_total_locals(g_symstack);
+    if (out_locals_aligned) {
+        *out_locals_aligned = (total_bytes + 15) & ~15;
+    }
+
+    symstack_pop_scope(g_symstack);
+}
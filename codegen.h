@@ -1,7 +1,20 @@
 #pragma once
 #include "parser.h"
+#include "flat_ast.h"
 #include "stack_machine_ir.h"
 
+// Functions callable from generated code: IR_CALL's immediate is the
+// index into `names`. Arrays must stay alive during code generation.
+void gen_set_callees(const char* const* names, const int* param_counts, int count);
+
 // Generate IR code for a full function.
 // If out_locals_aligned is NULL, locals are ignored.
-void gen_function(Function* f, IRList* out_ir, int* out_locals_aligned);
\ No newline at end of file
+void gen_function(Function* f, IRList* out_ir, int* out_locals_aligned);
+
+// Sethi-Ullman label every expression of fn, then flatten it into out
+// (flat_init'ed) so its operand order is the one gen_expr would use.
+void gen_flatten_function(Function* fn, FlatAst* out);
+
+// Same as gen_function, but reads a flattened copy of the function and
+// emits each expression with a forward scan instead of recursion.
+void gen_function_flat(const FlatAst* a, IRList* out_ir, int* out_locals_aligned);
\ No newline at end of file
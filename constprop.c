@@ -0,0 +1,408 @@
+#include "constprop.h"
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+// ----------------------------------------------------------
+// Environment: variable name -> known constant (or unknown)
+//
+// A scoped list: a let appends a binding, lookups search from the
+// newest, and leaving a block truncates back to its entry count, so a
+// shadowing let never disturbs the facts about the outer variable.
+// ----------------------------------------------------------
+typedef struct {
+    const char* name;
+    bool known;
+    int value;
+} ConstVar;
+
+typedef struct {
+    ConstVar* vars;
+    int count;
+    int cap;
+    Allocator* A;
+} ConstEnv;
+
+static ConstVar* env_find(ConstEnv* env, const char* name) {
+    for (int i = env->count - 1; i >= 0; i--) {
+        if (strcmp(env->vars[i].name, name) == 0) return &env->vars[i];
+    }
+    return NULL;
+}
+
+// let: a new binding in the innermost scope
+static void env_declare(ConstEnv* env, const char* name, bool known, int value) {
+    if (env->count == env->cap) {
+        env->cap = (env->cap == 0) ? 16 : env->cap * 2;
+        env->vars = mem_realloc(env->A, env->vars, sizeof(ConstVar) * env->cap);
+    }
+    env->vars[env->count++] = (ConstVar){ name, known, value };
+}
+
+// set: update the binding the name resolves to (an undeclared name
+// fails in codegen; tracking it here is harmless)
+static void env_set(ConstEnv* env, const char* name, bool known, int value) {
+    ConstVar* v = env_find(env, name);
+    if (!v) {
+        env_declare(env, name, known, value);
+        return;
+    }
+    v->known = known;
+    v->value = value;
+}
+
+// ----------------------------------------------------------
+// Expression helpers
+// ----------------------------------------------------------
+
+static void make_int(Allocator* A, Expr* e, int value) {
+    if (e->kind == EXPR_VAR) mem_free(A, e->var_name);
+    if (e->kind == EXPR_BINOP) {
+        free_expr(A, e->bin.lhs);
+        free_expr(A, e->bin.rhs);
+    }
+    e->kind = EXPR_INT;
+    e->int_value = value;
+}
+
+// Evaluate op exactly as the 64-bit backend would. Returns false when
+// the operation may trap (idiv by 0) or the result does not fit an int.
+static bool eval_binop(TokenType op, int a, int b, int* out) {
+    long long l = a, r = b, v;
+    switch (op) {
+        case T_PLUS:  v = l + r; break;
+        case T_MINUS: v = l - r; break;
+        case T_STAR:  v = l * r; break;
+        case T_SLASH:
+            if (r == 0) return false;
+            v = l / r;
+            break;
+        case T_PERCENT:
+            if (r == 0) return false;
+            v = l % r;
+            break;
+        case T_LESS:          v = l < r; break;
+        case T_LESS_EQUAL:    v = l <= r; break;
+        case T_GREATER:       v = l > r; break;
+        case T_GREATER_EQUAL: v = l >= r; break;
+        case T_EQUAL_EQUAL:   v = l == r; break;
+        case T_BANG_EQUAL:    v = l != r; break;
+        default:
+            return false;
+    }
+    if (v < INT_MIN || v > INT_MAX) return false;
+    *out = (int)v;
+    return true;
+}
+
+static void fold_expr(Expr* e, ConstEnv* env) {
+    switch (e->kind) {
+        case EXPR_INT:
+            break;
+
+        case EXPR_VAR: {
+            ConstVar* v = env_find(env, e->var_name);
+            if (v && v->known) make_int(env->A, e, v->value);
+            break;
+        }
+
+        case EXPR_BINOP: {
+            fold_expr(e->bin.lhs, env);
+            fold_expr(e->bin.rhs, env);
+            int value;
+            if (e->bin.lhs->kind == EXPR_INT && e->bin.rhs->kind == EXPR_INT &&
+                eval_binop(e->bin.op, e->bin.lhs->int_value, e->bin.rhs->int_value, &value)) {
+                make_int(env->A, e, value);
+            }
+            break;
+        }
+
+        case EXPR_CALL:
+            for (int i = 0; i < e->call.argc; i++) fold_expr(e->call.args[i], env);
+            break;
+    }
+}
+
+// True if evaluating e can never fault. Register values are 64-bit, so
+// a divisor is only safe when it is a constant other than 0 and -1.
+// A call may fault or never return, so it is never pure.
+static bool expr_is_pure(Expr* e) {
+    if (e->kind == EXPR_CALL) return false;
+    if (e->kind != EXPR_BINOP) return true;
+    if (e->bin.op == T_SLASH || e->bin.op == T_PERCENT) {
+        Expr* d = e->bin.rhs;
+        if (d->kind != EXPR_INT || d->int_value == 0 || d->int_value == -1) return false;
+    }
+    return expr_is_pure(e->bin.lhs) && expr_is_pure(e->bin.rhs);
+}
+
+static bool expr_uses(Expr* e, const char* name) {
+    if (!e) return false;
+    if (e->kind == EXPR_VAR) return strcmp(e->var_name, name) == 0;
+    if (e->kind == EXPR_BINOP) return expr_uses(e->bin.lhs, name) || expr_uses(e->bin.rhs, name);
+    if (e->kind == EXPR_CALL) {
+        for (int i = 0; i < e->call.argc; i++) {
+            if (expr_uses(e->call.args[i], name)) return true;
+        }
+    }
+    return false;
+}
+
+static const char* stmt_target(Stmt* s) {
+    if (s->kind == STMT_LET) return s->let_.name;
+    if (s->kind == STMT_SET) return s->set_.name;
+    return NULL;
+}
+
+static Expr* stmt_expr(Stmt* s) {
+    switch (s->kind) {
+        case STMT_LET:   return s->let_.init;
+        case STMT_SET:   return s->set_.expr;
+        case STMT_IF:    return s->if_.cond;
+        case STMT_WHILE: return s->while_.cond;
+        case STMT_BLOCK: return NULL;
+        default:         return s->ret_.expr;
+    }
+}
+
+static bool block_mentions(const Block* b, const char* name);
+
+// Does s, including any nested body, read or assign `name`?
+static bool stmt_mentions(Stmt* s, const char* name) {
+    if (expr_uses(stmt_expr(s), name)) return true;
+    const char* t = stmt_target(s);
+    if (t && strcmp(t, name) == 0) return true;
+    if (s->kind == STMT_IF)
+        return block_mentions(&s->if_.then_, name) || block_mentions(&s->if_.else_, name);
+    if (s->kind == STMT_WHILE) return block_mentions(&s->while_.body, name);
+    if (s->kind == STMT_BLOCK) return block_mentions(&s->block_, name);
+    return false;
+}
+
+static bool block_mentions(const Block* b, const char* name) {
+    for (int i = 0; i < b->count; i++) {
+        if (stmt_mentions(b->stmts[i], name)) return true;
+    }
+    return false;
+}
+
+// ----------------------------------------------------------
+// Forward pass: propagate and fold
+// ----------------------------------------------------------
+
+// Mark every variable assigned anywhere in b as unknown. A let inside b
+// counts too: it may shadow the name, and forgetting is always safe.
+static void forget_assigned(ConstEnv* env, const Block* b) {
+    for (int i = 0; i < b->count; i++) {
+        Stmt* s = b->stmts[i];
+        const char* t = stmt_target(s);
+        if (t) {
+            ConstVar* v = env_find(env, t);
+            if (v) v->known = false;
+        }
+        if (s->kind == STMT_IF) {
+            forget_assigned(env, &s->if_.then_);
+            forget_assigned(env, &s->if_.else_);
+        } else if (s->kind == STMT_WHILE) {
+            forget_assigned(env, &s->while_.body);
+        } else if (s->kind == STMT_BLOCK) {
+            forget_assigned(env, &s->block_);
+        }
+    }
+}
+
+static ConstEnv env_copy(const ConstEnv* env) {
+    ConstEnv c = { .count = env->count, .cap = env->count, .A = env->A };
+    c.vars = mem_alloc(env->A, sizeof(ConstVar) * (env->count ? env->count : 1));
+    if (env->count) memcpy(c.vars, env->vars, sizeof(ConstVar) * env->count);
+    return c;
+}
+
+static void fold_stmts(Stmt** stmts, int count, ConstEnv* env);
+
+// Fold a body as its own scope: its lets are dropped at the end, while
+// sets to outer variables keep their effect
+static void fold_scope(const Block* b, ConstEnv* env) {
+    int mark = env->count;
+    fold_stmts(b->stmts, b->count, env);
+    env->count = mark;
+}
+
+static void fold_stmt(Stmt* s, ConstEnv* env) {
+    switch (s->kind) {
+        case STMT_IF: {
+            // each branch starts from the facts before the if; afterwards
+            // only variables neither branch assigns keep their value
+            fold_expr(s->if_.cond, env);
+            ConstEnv branch = env_copy(env);
+            fold_stmts(s->if_.then_.stmts, s->if_.then_.count, &branch);
+            mem_free(env->A, branch.vars);
+            branch = env_copy(env);
+            fold_stmts(s->if_.else_.stmts, s->if_.else_.count, &branch);
+            mem_free(env->A, branch.vars);
+            forget_assigned(env, &s->if_.then_);
+            forget_assigned(env, &s->if_.else_);
+            break;
+        }
+
+        case STMT_WHILE:
+            // facts about anything the body assigns do not survive the back edge
+            forget_assigned(env, &s->while_.body);
+            fold_expr(s->while_.cond, env);
+            fold_scope(&s->while_.body, env);
+            forget_assigned(env, &s->while_.body);
+            break;
+
+        case STMT_BLOCK:
+            fold_scope(&s->block_, env);
+            break;
+
+        default: {
+            Expr* e = stmt_expr(s);
+            if (e) fold_expr(e, env);
+
+            const char* t = stmt_target(s);
+            bool known = e && e->kind == EXPR_INT;
+            if (s->kind == STMT_LET) env_declare(env, t, known, known ? e->int_value : 0);
+            else if (t) env_set(env, t, known, known ? e->int_value : 0);
+            break;
+        }
+    }
+}
+
+static void fold_stmts(Stmt** stmts, int count, ConstEnv* env) {
+    for (int i = 0; i < count; i++) fold_stmt(stmts[i], env);
+}
+
+// ----------------------------------------------------------
+// Backward pass: drop stores that are never read
+// ----------------------------------------------------------
+
+// A statement list being cleaned, and where control goes when it ends
+typedef struct Scope {
+    Stmt** stmts;
+    int count;
+    bool loops;                  // a while body: its end re-runs the loop
+    const struct Scope* parent;  // NULL for the function body
+    int resume;                  // index in parent right after this body's statement
+} Scope;
+
+// Is `name` declared by a let in stmts[0, before)?
+static bool declares(const Scope* sc, int before, const char* name) {
+    for (int i = 0; i < before; i++) {
+        Stmt* s = sc->stmts[i];
+        if (s && s->kind == STMT_LET && strcmp(s->let_.name, name) == 0) return true;
+    }
+    return false;
+}
+
+// Can the value `name` holds just before stmts[from] still be read?
+// Statements run in order; an if, while or block that mentions the name
+// at all (even a shadowing let) counts as a read. At the end of the list
+// a variable it declares is gone, a loop body goes round again, and any
+// other body continues in its parent.
+static bool live_from(const Scope* sc, int from, const char* name) {
+    for (int i = from; i < sc->count; i++) {
+        Stmt* s = sc->stmts[i];
+        if (!s) continue;
+        if (s->kind == STMT_IF || s->kind == STMT_WHILE || s->kind == STMT_BLOCK) {
+            if (stmt_mentions(s, name)) return true;
+            continue;
+        }
+        if (expr_uses(stmt_expr(s), name)) return true;
+        if (s->kind == STMT_RETURN) return false;
+        if (s->kind == STMT_SET && strcmp(s->set_.name, name) == 0) return false;
+        if (s->kind == STMT_LET && strcmp(s->let_.name, name) == 0) return true;  // shadowed
+    }
+    if (!sc->parent || declares(sc, from, name)) return false;
+    if (sc->loops) return true;
+    return live_from(sc->parent, sc->resume, name);
+}
+
+static bool referenced_from(const Scope* sc, int from, const char* name) {
+    for (int i = from; i < sc->count; i++) {
+        Stmt* s = sc->stmts[i];
+        if (s && stmt_mentions(s, name)) return true;
+    }
+    return false;
+}
+
+static int clean_scope(Allocator* A, Scope* sc);
+
+static int clean_body(Allocator* A, Block* b, bool loops, const Scope* parent, int resume) {
+    Scope sc = { b->stmts, b->count, loops, parent, resume };
+    int removed = clean_scope(A, &sc);
+    b->count = sc.count;
+    return removed;
+}
+
+// Remove dead stores in the list (last first, so a removal can expose an
+// earlier one), then lets nothing mentions any more, then compact
+static int clean_scope(Allocator* A, Scope* sc) {
+    int removed = 0;
+    for (int i = sc->count - 1; i >= 0; i--) {
+        Stmt* s = sc->stmts[i];
+        if (s->kind == STMT_IF) {
+            removed += clean_body(A, &s->if_.then_, false, sc, i + 1);
+            removed += clean_body(A, &s->if_.else_, false, sc, i + 1);
+            continue;
+        }
+        if (s->kind == STMT_WHILE) {
+            removed += clean_body(A, &s->while_.body, true, sc, i + 1);
+            continue;
+        }
+        if (s->kind == STMT_BLOCK) {
+            removed += clean_body(A, &s->block_, false, sc, i + 1);
+            continue;
+        }
+
+        const char* t = stmt_target(s);
+        Expr* e = stmt_expr(s);
+        if (!t || !e || live_from(sc, i + 1, t) || !expr_is_pure(e)) continue;
+
+        if (s->kind == STMT_SET) {
+            free_stmt(A, s);
+            sc->stmts[i] = NULL;
+            removed++;
+        } else {
+            free_expr(A, e);
+            s->let_.init = NULL;
+        }
+    }
+
+    // ---- Drop declarations with no remaining references ----
+    for (int i = 0; i < sc->count; i++) {
+        Stmt* s = sc->stmts[i];
+        if (!s || s->kind != STMT_LET || s->let_.init) continue;
+        if (referenced_from(sc, i + 1, s->let_.name)) continue;
+        free_stmt(A, s);
+        sc->stmts[i] = NULL;
+        removed++;
+    }
+
+    int n = 0;
+    for (int i = 0; i < sc->count; i++) {
+        if (sc->stmts[i]) sc->stmts[n++] = sc->stmts[i];
+    }
+    sc->count = n;
+    return removed;
+}
+
+// ----------------------------------------------------------
+// Driver
+// ----------------------------------------------------------
+
+int constprop_function(Function* fn) {
+    ConstEnv env = { .A = fn->A };
+
+    // ---- Forward: propagate and fold ----
+    fold_stmts(fn->stmts, fn->stmt_count, &env);
+    mem_free(env.A, env.vars);
+
+    // ---- Backward: dead stores and declarations, every body included ----
+    Scope top = { fn->stmts, fn->stmt_count, false, NULL, 0 };
+    int removed = clean_scope(fn->A, &top);
+    fn->stmt_count = top.count;
+    return removed;
+}
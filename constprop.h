@@ -0,0 +1,11 @@
+#pragma once
+#include "parser.h"
+
+// Constant propagation and folding over one function's statements.
+// Known values flow through let/set; foldable expressions become
+// EXPR_INT and stores nobody reads any more are removed (so the frame
+// built by gen_function shrinks). Division/modulo that could trap at
+// run time and results that do not fit the 32-bit IR immediate are
+// left for the program to compute.
+// Returns the number of statements removed.
+int constprop_function(Function* fn);
@@ -0,0 +1,192 @@
+#include "flat_ast.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void flat_init(FlatAst* a, Allocator* A) {
+    memset(a, 0, sizeof *a);
+    a->A = A ? A : alloc_system();
+}
+
+void flat_free(FlatAst* a) {
+    Allocator* A = a->A;
+    mem_free(A, a->kind);
+    mem_free(A, a->lhs);
+    mem_free(A, a->rhs);
+    mem_free(A, a->payload);
+    mem_free(A, a->stmt_kind);
+    mem_free(A, a->stmt_name);
+    mem_free(A, a->stmt_first);
+    mem_free(A, a->stmt_root);
+    mem_free(A, a->stmt_line);
+    mem_free(A, a->extra);
+    for (uint32_t i = 0; i < a->name_count; i++) mem_free(A, a->names[i]);
+    mem_free(A, a->names);
+    flat_init(a, A);
+}
+
+uint32_t flat_intern(FlatAst* a, const char* name) {
+    for (uint32_t i = 0; i < a->name_count; i++) {
+        if (strcmp(a->names[i], name) == 0) return i;
+    }
+    if (a->name_count == a->name_cap) {
+        a->name_cap = (a->name_cap == 0) ? 16 : a->name_cap * 2;
+        a->names = mem_realloc(a->A, a->names, sizeof(char*) * a->name_cap);
+    }
+    a->names[a->name_count] = mem_strdup(a->A, name);
+    return a->name_count++;
+}
+
+NodeRef flat_add_expr(FlatAst* a, ExprKind kind, NodeRef lhs, NodeRef rhs, int32_t payload) {
+    if (a->count == a->cap) {
+        a->cap = (a->cap == 0) ? 64 : a->cap * 2;
+        a->kind    = mem_realloc(a->A, a->kind,    sizeof(uint8_t) * a->cap);
+        a->lhs     = mem_realloc(a->A, a->lhs,     sizeof(NodeRef) * a->cap);
+        a->rhs     = mem_realloc(a->A, a->rhs,     sizeof(NodeRef) * a->cap);
+        a->payload = mem_realloc(a->A, a->payload, sizeof(int32_t) * a->cap);
+    }
+    NodeRef n = a->count++;
+    a->kind[n] = (uint8_t)kind;
+    a->lhs[n] = lhs;
+    a->rhs[n] = rhs;
+    a->payload[n] = payload;
+    return n;
+}
+
+void flat_add_stmt(FlatAst* a, int kind, uint32_t name, NodeRef first, NodeRef root) {
+    if (a->stmt_count == a->stmt_cap) {
+        a->stmt_cap = (a->stmt_cap == 0) ? 16 : a->stmt_cap * 2;
+        a->stmt_kind  = mem_realloc(a->A, a->stmt_kind,  sizeof(uint8_t)  * a->stmt_cap);
+        a->stmt_name  = mem_realloc(a->A, a->stmt_name,  sizeof(uint32_t) * a->stmt_cap);
+        a->stmt_first = mem_realloc(a->A, a->stmt_first, sizeof(NodeRef)  * a->stmt_cap);
+        a->stmt_root  = mem_realloc(a->A, a->stmt_root,  sizeof(NodeRef)  * a->stmt_cap);
+        a->stmt_line  = mem_realloc(a->A, a->stmt_line,  sizeof(int32_t)  * a->stmt_cap);
+    }
+    uint32_t s = a->stmt_count++;
+    a->stmt_kind[s] = (uint8_t)kind;
+    a->stmt_name[s] = name;
+    a->stmt_first[s] = first;
+    a->stmt_root[s] = root;
+    a->stmt_line[s] = a->line;
+}
+
+uint32_t flat_add_extra(FlatAst* a, uint32_t value) {
+    if (a->extra_count == a->extra_cap) {
+        a->extra_cap = (a->extra_cap == 0) ? 16 : a->extra_cap * 2;
+        a->extra = mem_realloc(a->A, a->extra, sizeof(uint32_t) * a->extra_cap);
+    }
+    a->extra[a->extra_count] = value;
+    return a->extra_count++;
+}
+
+// ----------------------------------------------------------
+// Conversion from the pointer AST (post-order append)
+// ----------------------------------------------------------
+
+static NodeRef flat_from_expr(FlatAst* a, Expr* e) {
+    switch (e->kind) {
+        case EXPR_INT:
+            return flat_add_expr(a, EXPR_INT, NODE_NONE, NODE_NONE, e->int_value);
+
+        case EXPR_VAR:
+            return flat_add_expr(a, EXPR_VAR, NODE_NONE, NODE_NONE,
+                                 (int32_t)flat_intern(a, e->var_name));
+
+        case EXPR_BINOP: {
+            // Heavier operand first by the caller's su_need labels, as
+            // gen_expr orders it; codegen sees the swap as rhs < lhs
+            NodeRef l, r;
+            if (!e->su_call && e->bin.rhs->su_need > e->bin.lhs->su_need) {
+                r = flat_from_expr(a, e->bin.rhs);
+                l = flat_from_expr(a, e->bin.lhs);
+            } else {
+                l = flat_from_expr(a, e->bin.lhs);
+                r = flat_from_expr(a, e->bin.rhs);
+            }
+            return flat_add_expr(a, EXPR_BINOP, l, r, e->bin.op);
+        }
+
+        case EXPR_CALL: {
+            // args are appended first (post-order); their roots go to extra[]
+            NodeRef roots[64];
+            if (e->call.argc > 64) {
+                fprintf(stderr, "Too many call arguments\n");
+                exit(1);
+            }
+            for (int i = 0; i < e->call.argc; i++) roots[i] = flat_from_expr(a, e->call.args[i]);
+            uint32_t first = a->extra_count;
+            for (int i = 0; i < e->call.argc; i++) flat_add_extra(a, roots[i]);
+            return flat_add_expr(a, EXPR_CALL, first, (NodeRef)e->call.argc,
+                                 (int32_t)flat_intern(a, e->call.name));
+        }
+
+        default:
+            fprintf(stderr, "Unknown expression kind.\n");
+            exit(1);
+    }
+}
+
+static void flat_from_stmts(FlatAst* a, Stmt** stmts, int count);
+
+static void flat_from_stmt(FlatAst* a, Stmt* s) {
+    NodeRef first = a->count;
+    a->line = s->line;
+    switch (s->kind) {
+        case STMT_LET: {
+            NodeRef root = s->let_.init ? flat_from_expr(a, s->let_.init) : NODE_NONE;
+            flat_add_stmt(a, STMT_LET, flat_intern(a, s->let_.name), first, root);
+            break;
+        }
+        case STMT_SET: {
+            NodeRef root = flat_from_expr(a, s->set_.expr);
+            flat_add_stmt(a, STMT_SET, flat_intern(a, s->set_.name), first, root);
+            break;
+        }
+        case STMT_RETURN: {
+            NodeRef root = flat_from_expr(a, s->ret_.expr);
+            flat_add_stmt(a, STMT_RETURN, 0, first, root);
+            break;
+        }
+        case STMT_IF: {
+            NodeRef root = flat_from_expr(a, s->if_.cond);
+            flat_add_stmt(a, STMT_IF, 0, first, root);
+            flat_from_stmts(a, s->if_.then_.stmts, s->if_.then_.count);
+            if (s->if_.else_.count > 0) {
+                flat_add_stmt(a, FLAT_ELSE, 0, a->count, NODE_NONE);
+                flat_from_stmts(a, s->if_.else_.stmts, s->if_.else_.count);
+            }
+            flat_add_stmt(a, FLAT_END, 0, a->count, NODE_NONE);
+            break;
+        }
+        case STMT_WHILE: {
+            NodeRef root = flat_from_expr(a, s->while_.cond);
+            flat_add_stmt(a, STMT_WHILE, 0, first, root);
+            flat_from_stmts(a, s->while_.body.stmts, s->while_.body.count);
+            flat_add_stmt(a, FLAT_END, 0, a->count, NODE_NONE);
+            break;
+        }
+        case STMT_BLOCK:
+            flat_add_stmt(a, STMT_BLOCK, 0, first, NODE_NONE);
+            flat_from_stmts(a, s->block_.stmts, s->block_.count);
+            flat_add_stmt(a, FLAT_END, 0, a->count, NODE_NONE);
+            break;
+        default:
+            fprintf(stderr, "Unknown statement kind.\n");
+            exit(1);
+    }
+}
+
+static void flat_from_stmts(FlatAst* a, Stmt** stmts, int count) {
+    for (int i = 0; i < count; i++) flat_from_stmt(a, stmts[i]);
+}
+
+void flat_from_function(FlatAst* a, Function* fn) {
+    a->fn_name = flat_intern(a, fn->name);
+    a->fn_line = fn->line;
+    a->exported = fn->exported;
+    a->param_first = a->extra_count;
+    a->param_count = (uint32_t)fn->param_count;
+    for (int i = 0; i < fn->param_count; i++) flat_add_extra(a, flat_intern(a, fn->params[i]));
+
+    flat_from_stmts(a, fn->stmts, fn->stmt_count);
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include "parser.h"
+
+// ==========================================================
+// Flat AST: struct-of-arrays copy of one function for codegen.
+//
+// The pointer AST stays the compiler's representation: the parser and
+// every pass work on it, and --flat-ast flattens each optimized function
+// afterwards, so this is an extra copy rather than a replacement.
+// Expression nodes are appended in post-order, so every child has a
+// smaller index than its parent and the nodes of one expression form
+// the contiguous range [first, root]; gen_function_flat emits one with a
+// left-to-right scan over that range.
+// ==========================================================
+
+typedef uint32_t NodeRef;
+#define NODE_NONE UINT32_MAX
+
+// Control flow stays a linear statement list: STMT_IF / STMT_WHILE hold
+// the condition and open a body that FLAT_END closes, as does a bare
+// STMT_BLOCK; FLAT_ELSE splits an if. Both markers are stmt_kind values
+// beyond StmtKind.
+//   STMT_IF c, then..., [FLAT_ELSE, else...,] FLAT_END
+//   STMT_WHILE c, body..., FLAT_END
+//   STMT_BLOCK, body..., FLAT_END
+enum { FLAT_ELSE = STMT_BLOCK + 1, FLAT_END };
+
+typedef struct {
+    // ---- expression nodes ----
+    uint8_t*  kind;       // ExprKind
+    NodeRef*  lhs;        // EXPR_BINOP: left child, EXPR_CALL: first arg in extra[]
+    NodeRef*  rhs;        // EXPR_BINOP: right child (below lhs if pushed first), EXPR_CALL: argc
+    int32_t*  payload;    // EXPR_INT: value, EXPR_VAR/EXPR_CALL: name id, EXPR_BINOP: TokenType
+    uint32_t  count;
+    uint32_t  cap;
+
+    // ---- statements ----
+    uint8_t*  stmt_kind;  // StmtKind or FLAT_ELSE / FLAT_END
+    uint32_t* stmt_name;  // STMT_LET / STMT_SET: name id
+    NodeRef*  stmt_first; // first node of the statement's expression
+    NodeRef*  stmt_root;  // root node (NODE_NONE for a bare let)
+    int32_t*  stmt_line;  // source line
+    uint32_t  stmt_count;
+    uint32_t  stmt_cap;
+
+    // ---- interned identifiers ----
+    char**    names;
+    uint32_t  name_count;
+    uint32_t  name_cap;
+
+    // ---- variable-length lists: call argument roots, parameter names ----
+    uint32_t* extra;
+    uint32_t  extra_count;
+    uint32_t  extra_cap;
+
+    uint32_t  fn_name;    // name id of the function
+    int32_t   fn_line;    // source line of the `fn` header
+    int32_t   line;       // line recorded by the next flat_add_stmt
+    uint32_t  param_first;// parameter name ids: extra[param_first .. +param_count)
+    uint32_t  param_count;
+    bool      exported;
+    Allocator* A;
+} FlatAst;
+
+void flat_init(FlatAst* a, Allocator* A);
+void flat_free(FlatAst* a);
+
+uint32_t flat_intern(FlatAst* a, const char* name);
+NodeRef  flat_add_expr(FlatAst* a, ExprKind kind, NodeRef lhs, NodeRef rhs, int32_t payload);
+void     flat_add_stmt(FlatAst* a, int kind, uint32_t name, NodeRef first, NodeRef root);
+uint32_t flat_add_extra(FlatAst* a, uint32_t value);
+
+// Convert a pointer-based function into flat form. A binop's operands
+// are appended heavier first by their su_need labels, which must be set
+// (gen_flatten_function does both).
+void flat_from_function(FlatAst* a, Function* fn);
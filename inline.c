@@ -0,0 +1,284 @@
+#include "inline.h"
+#include "callgraph.h"
+#include <string.h>
+
+// ----------------------------------------------------------
+// Callee analysis
+// ----------------------------------------------------------
+
+static bool expr_has_call(Expr* e) {
+    if (!e) return false;
+    if (e->kind == EXPR_CALL) return true;
+    if (e->kind == EXPR_BINOP) return expr_has_call(e->bin.lhs) || expr_has_call(e->bin.rhs);
+    return false;
+}
+
+static int expr_size(Expr* e) {
+    if (!e) return 0;
+    if (e->kind == EXPR_BINOP) return 1 + expr_size(e->bin.lhs) + expr_size(e->bin.rhs);
+    if (e->kind == EXPR_CALL) {
+        int n = 1;
+        for (int i = 0; i < e->call.argc; i++) n += expr_size(e->call.args[i]);
+        return n;
+    }
+    return 1;
+}
+
+static Expr* stmt_expr(Stmt* s) {
+    switch (s->kind) {
+        case STMT_LET:    return s->let_.init;
+        case STMT_SET:    return s->set_.expr;
+        case STMT_RETURN: return s->ret_.expr;
+        case STMT_IF:     return s->if_.cond;
+        case STMT_WHILE:  return s->while_.cond;
+        case STMT_BLOCK:  return NULL;
+    }
+    return NULL;
+}
+
+// Size in nodes if fn is an inlinable leaf, otherwise -1
+static int leaf_size(Function* fn) {
+    if (fn->stmt_count == 0 || fn->stmts[fn->stmt_count - 1]->kind != STMT_RETURN) return -1;
+    int size = 0;
+    for (int i = 0; i < fn->stmt_count; i++) {
+        Stmt* s = fn->stmts[i];
+        if (s->kind == STMT_IF || s->kind == STMT_WHILE || s->kind == STMT_BLOCK)
+            return -1;  // straight-line, single-scope only
+        if (s->kind == STMT_RETURN && i != fn->stmt_count - 1) return -1;
+        if (expr_has_call(stmt_expr(s))) return -1;
+        size += 1 + expr_size(stmt_expr(s));
+    }
+    return size;
+}
+
+// Can evaluating e fault (idiv) or not return (call)?
+static bool expr_may_fault(Expr* e) {
+    if (!e) return false;
+    if (e->kind == EXPR_CALL) return true;
+    if (e->kind != EXPR_BINOP) return false;
+    if (e->bin.op == T_SLASH || e->bin.op == T_PERCENT) {
+        Expr* d = e->bin.rhs;
+        if (d->kind != EXPR_INT || d->int_value == 0 || d->int_value == -1) return true;
+    }
+    return expr_may_fault(e->bin.lhs) || expr_may_fault(e->bin.rhs);
+}
+
+// ----------------------------------------------------------
+// Renamed copies of callee code
+// ----------------------------------------------------------
+
+typedef struct {
+    Program* prog;
+    Function* caller;
+    int* sizes;          // leaf_size per function index
+    Allocator* A;
+    Stmt** out;          // rebuilt statement list of the caller
+    int count;
+    int cap;
+    int site;            // per-caller inline counter (fresh names)
+    int budget;
+    int inlined;
+    int line;            // line of the statement being rewritten
+    FILE* report;
+} InlineCtx;
+
+static char* fresh_name(InlineCtx* c, const char* callee, const char* name) {
+    int n = snprintf(NULL, 0, "%s.%d.%s", callee, c->site, name);
+    char* s = mem_alloc(c->A, n + 1);
+    snprintf(s, n + 1, "%s.%d.%s", callee, c->site, name);
+    return s;
+}
+
+static Expr* copy_renamed(InlineCtx* c, const char* callee, Expr* e) {
+    Expr* copy = mem_alloc(c->A, sizeof(Expr));
+    copy->kind = e->kind;
+    switch (e->kind) {
+        case EXPR_INT:
+            copy->int_value = e->int_value;
+            break;
+        case EXPR_VAR:
+            copy->var_name = fresh_name(c, callee, e->var_name);
+            break;
+        case EXPR_BINOP:
+            copy->bin.op = e->bin.op;
+            copy->bin.lhs = copy_renamed(c, callee, e->bin.lhs);
+            copy->bin.rhs = copy_renamed(c, callee, e->bin.rhs);
+            break;
+        case EXPR_CALL:  // leaves have no calls
+            break;
+    }
+    return copy;
+}
+
+static void emit_stmt(InlineCtx* c, Stmt* s) {
+    if (c->count == c->cap) {
+        c->cap = (c->cap == 0) ? 16 : c->cap * 2;
+        c->out = mem_realloc(c->A, c->out, sizeof(Stmt*) * c->cap);
+    }
+    c->out[c->count++] = s;
+}
+
+static void emit_let(InlineCtx* c, char* name, Expr* init) {
+    Stmt* s = mem_alloc(c->A, sizeof(Stmt));
+    s->kind = STMT_LET;
+    s->line = c->line;
+    s->let_.name = name;
+    s->let_.init = init;
+    emit_stmt(c, s);
+}
+
+// Hoist callee's body in front of the current statement and return the
+// (renamed) expression that replaces the call.
+static Expr* expand_call(InlineCtx* c, Function* callee, Expr* call) {
+    c->site++;
+    const char* cn = callee->name;
+
+    // Parameters become fresh locals initialized with the arguments
+    for (int i = 0; i < callee->param_count; i++)
+        emit_let(c, fresh_name(c, cn, callee->params[i]), call->call.args[i]);
+
+    for (int i = 0; i < callee->stmt_count - 1; i++) {
+        Stmt* s = callee->stmts[i];
+        if (s->kind == STMT_LET) {
+            emit_let(c, fresh_name(c, cn, s->let_.name),
+                     s->let_.init ? copy_renamed(c, cn, s->let_.init) : NULL);
+        } else {
+            Stmt* set = mem_alloc(c->A, sizeof(Stmt));
+            set->kind = STMT_SET;
+            set->line = c->line;
+            set->set_.name = fresh_name(c, cn, s->set_.name);
+            set->set_.expr = copy_renamed(c, cn, s->set_.expr);
+            emit_stmt(c, set);
+        }
+    }
+    Expr* result = copy_renamed(c, cn, callee->stmts[callee->stmt_count - 1]->ret_.expr);
+
+    if (c->report)
+        fprintf(c->report, "inline: %s:%d: inlined call to %s\n", c->caller->name, c->line, cn);
+
+    mem_free(c->A, call->call.args);
+    mem_free(c->A, call->call.name);
+    mem_free(c->A, call);
+    return result;
+}
+
+// Rewrite e in evaluation order. *prefix_pure says whether everything
+// evaluated so far that stays in the statement is free of faults and
+// calls; only then may a callee body be hoisted ahead of it.
+static Expr* inline_expr(InlineCtx* c, Expr* e, bool* prefix_pure) {
+    switch (e->kind) {
+        case EXPR_INT:
+        case EXPR_VAR:
+            return e;
+
+        case EXPR_BINOP: {
+            e->bin.lhs = inline_expr(c, e->bin.lhs, prefix_pure);
+            e->bin.rhs = inline_expr(c, e->bin.rhs, prefix_pure);
+            if (e->bin.op == T_SLASH || e->bin.op == T_PERCENT) {
+                Expr* d = e->bin.rhs;
+                if (d->kind != EXPR_INT || d->int_value == 0 || d->int_value == -1)
+                    *prefix_pure = false;
+            }
+            return e;
+        }
+
+        case EXPR_CALL: {
+            bool pure_before = *prefix_pure;
+            for (int i = 0; i < e->call.argc; i++)
+                e->call.args[i] = inline_expr(c, e->call.args[i], prefix_pure);
+
+            int idx = program_find_function(c->prog, e->call.name);
+            Function* callee = idx >= 0 ? c->prog->fns[idx] : NULL;
+            if (pure_before && callee && callee != c->caller && c->sizes[idx] >= 0 &&
+                c->sizes[idx] <= INLINE_MAX_CALLEE && c->sizes[idx] <= c->budget &&
+                callee->param_count == e->call.argc) {
+                c->budget -= c->sizes[idx];
+                c->inlined++;
+                Expr* result = expand_call(c, callee, e);
+                // args are now hoisted; the return expression stays inline
+                *prefix_pure = !expr_may_fault(result);
+                return result;
+            }
+            *prefix_pure = false;
+            return e;
+        }
+    }
+    return e;
+}
+
+static void inline_stmt(InlineCtx* c, Stmt* s);
+
+// Rewrite a nested body into its own statement list. Hoisted callee
+// code lands in the body itself, so its fresh lets are scoped to it and
+// its argument expressions see the same bindings the call did (a let's
+// initializer is evaluated before the name it declares comes into scope).
+static void inline_block(InlineCtx* c, Block* b) {
+    Stmt** out = c->out;
+    int count = c->count, cap = c->cap;
+    c->out = NULL;
+    c->count = c->cap = 0;
+    for (int k = 0; k < b->count; k++) inline_stmt(c, b->stmts[k]);
+    mem_free(c->A, b->stmts);
+    b->stmts = c->out;
+    b->count = c->count;
+    c->out = out;
+    c->count = count;
+    c->cap = cap;
+}
+
+static void inline_stmt(InlineCtx* c, Stmt* s) {
+    bool pure = true;
+    c->line = s->line;
+    switch (s->kind) {
+        case STMT_LET:
+            if (s->let_.init) s->let_.init = inline_expr(c, s->let_.init, &pure);
+            break;
+        case STMT_SET:
+            s->set_.expr = inline_expr(c, s->set_.expr, &pure);
+            break;
+        case STMT_RETURN:
+            s->ret_.expr = inline_expr(c, s->ret_.expr, &pure);
+            break;
+        case STMT_IF:
+            // the condition runs once, so its callees may be hoisted before the if
+            s->if_.cond = inline_expr(c, s->if_.cond, &pure);
+            inline_block(c, &s->if_.then_);
+            inline_block(c, &s->if_.else_);
+            break;
+        case STMT_WHILE:
+            // the condition is re-evaluated each iteration: leave its calls
+            inline_block(c, &s->while_.body);
+            break;
+        case STMT_BLOCK:
+            inline_block(c, &s->block_);
+            break;
+    }
+    emit_stmt(c, s);
+}
+
+// ----------------------------------------------------------
+// Driver
+// ----------------------------------------------------------
+
+int inline_program(Program* prog, FILE* report) {
+    int* sizes = mem_alloc(prog->A, sizeof(int) * (prog->count + 1));
+    for (int i = 0; i < prog->count; i++) sizes[i] = leaf_size(prog->fns[i]);
+
+    int total = 0;
+    for (int i = 0; i < prog->count; i++) {
+        Function* fn = prog->fns[i];
+        InlineCtx c = {
+            .prog = prog, .caller = fn, .sizes = sizes, .A = fn->A,
+            .budget = INLINE_CALLER_BUDGET, .report = report
+        };
+        for (int k = 0; k < fn->stmt_count; k++) inline_stmt(&c, fn->stmts[k]);
+
+        mem_free(fn->A, fn->stmts);
+        fn->stmts = c.out;
+        fn->stmt_count = c.count;
+        total += c.inlined;
+    }
+
+    mem_free(prog->A, sizes);
+    return total;
+}
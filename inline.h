@@ -0,0 +1,18 @@
+#pragma once
+#include <stdio.h>
+#include "parser.h"
+
+// Cost model: a callee is inlined when it is a leaf (no calls), its body
+// is straight-line let/set statements (no if/while) ending in a single
+// return, and its size in AST nodes is at most INLINE_MAX_CALLEE. Each
+// caller may grow by at most INLINE_CALLER_BUDGET nodes.
+#define INLINE_MAX_CALLEE    24
+#define INLINE_CALLER_BUDGET 512
+
+// Inline small leaf callees into their callers. The callee's body is
+// hoisted in front of the calling statement with every parameter and
+// local renamed to a fresh name ("callee.N.name"), so codegen gives them
+// their own frame slots in the caller's scope; the call expression is
+// replaced by the callee's return expression. Each inlined call site is
+// reported to `report` (may be NULL). Returns the number inlined.
+int inline_program(Program* prog, FILE* report);
@@ -0,0 +1,230 @@
+#include "jir.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ----------------------------------------------------------
+// Helper: growable byte buffer
+// ----------------------------------------------------------
+typedef struct {
+    uint8_t* data;
+    size_t len;
+    size_t cap;
+    Allocator* A;
+} ByteBuf;
+
+static void buf_put(ByteBuf* b, const void* src, size_t n) {
+    if (b->len + n > b->cap) {
+        while (b->len + n > b->cap) b->cap = (b->cap == 0) ? 256 : b->cap * 2;
+        b->data = mem_realloc(b->A, b->data, b->cap);
+    }
+    memcpy(b->data + b->len, src, n);
+    b->len += n;
+}
+
+static void buf_align4(ByteBuf* b) {
+    static const uint8_t zero[4] = {0};
+    if (b->len % 4) buf_put(b, zero, 4 - b->len % 4);
+}
+
+// ----------------------------------------------------------
+// Immediate encoding: zigzag + LEB128 (1 byte for -64..63)
+// ----------------------------------------------------------
+
+bool jir_op_has_imm(IROp op) {
+    switch (op) {
+        case IR_PUSH_INT:
+        case IR_LOAD:
+        case IR_STORE:
+        case IR_PARAM:
+        case IR_ARG:
+        case IR_CALL:
+        case IR_LINE:
+        case IR_LABEL:
+        case IR_JMP:
+        case IR_JZ:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void put_varint(ByteBuf* b, int value) {
+    uint32_t v = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    do {
+        uint8_t byte = v & 0x7f;
+        v >>= 7;
+        if (v) byte |= 0x80;
+        buf_put(b, &byte, 1);
+    } while (v);
+}
+
+// A 32-bit value takes at most 5 bytes; fails on a varint that runs
+// past end or is longer than that
+static bool get_varint(const uint8_t** pc, const uint8_t* end, int* out) {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (*pc >= end) return false;
+        uint8_t byte = *(*pc)++;
+        v |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *out = (int)((v >> 1) ^ (~(v & 1) + 1));
+            return true;
+        }
+    }
+    return false;
+}
+
+// ----------------------------------------------------------
+// Writer
+// ----------------------------------------------------------
+
+bool jir_write_file(const char* path, const JirFunctionDesc* fns, int count,
+                    const char* source, Allocator* A) {
+    ByteBuf strtab = { .A = A }, code = { .A = A };
+    JirFunctionEntry* index = mem_alloc(A, sizeof(JirFunctionEntry) * (count > 0 ? count : 1));
+
+    for (int i = 0; i < count; i++) {
+        index[i].name_offset = (uint32_t)strtab.len;
+        buf_put(&strtab, fns[i].name, strlen(fns[i].name) + 1);
+
+        index[i].code_offset = (uint32_t)code.len;
+        for (int k = 0; k < fns[i].ir->count; k++) {
+            IR instr = fns[i].ir->code[k];
+            uint8_t op = (uint8_t)instr.op;
+            buf_put(&code, &op, 1);
+            if (jir_op_has_imm(instr.op)) put_varint(&code, instr.imm);
+        }
+        index[i].code_size = (uint32_t)code.len - index[i].code_offset;
+        index[i].insn_count = (uint32_t)fns[i].ir->count;
+        index[i].frame_size = fns[i].frame_size;
+    }
+    JirHeader h = {0};
+    if (source) {
+        h.flags |= JIR_HAS_SOURCE;
+        h.source_offset = (uint32_t)strtab.len;
+        buf_put(&strtab, source, strlen(source) + 1);
+    }
+    buf_align4(&strtab);
+
+    memcpy(h.magic, JIR_MAGIC, 4);
+    h.version = JIR_VERSION;
+    h.function_count = (uint32_t)count;
+    h.index_offset = sizeof(JirHeader);
+    h.strtab_offset = h.index_offset + (uint32_t)(count * sizeof(JirFunctionEntry));
+    h.code_offset = h.strtab_offset + (uint32_t)strtab.len;
+    h.file_size = h.code_offset + (uint32_t)code.len;
+
+    FILE* out = fopen(path, "wb");
+    bool ok = out != NULL;
+    if (ok) {
+        ok = fwrite(&h, sizeof h, 1, out) == 1
+          && fwrite(index, sizeof(JirFunctionEntry), count, out) == (size_t)count
+          && fwrite(strtab.data, 1, strtab.len, out) == strtab.len
+          && fwrite(code.data, 1, code.len, out) == code.len;
+        ok = (fclose(out) == 0) && ok;
+    }
+
+    mem_free(A, index);
+    mem_free(A, strtab.data);
+    mem_free(A, code.data);
+    return ok;
+}
+
+// ----------------------------------------------------------
+// Reader
+// ----------------------------------------------------------
+
+static bool in_strtab(const JirModule* m, uint32_t off) {
+    const char* strtab = (const char*)(m->base + m->header->strtab_offset);
+    uint32_t strtab_size = m->header->code_offset - m->header->strtab_offset;
+    return off < strtab_size && memchr(strtab + off, '\0', strtab_size - off) != NULL;
+}
+
+bool jir_open(JirModule* m, const char* path) {
+    memset(m, 0, sizeof *m);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(JirHeader)) {
+        close(fd);
+        return false;
+    }
+
+    void* base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return false;
+
+    m->base = base;
+    m->size = st.st_size;
+    m->header = (const JirHeader*)base;
+
+    // Sections must be in order, aligned and inside the file
+    const JirHeader* h = m->header;
+    bool ok = memcmp(h->magic, JIR_MAGIC, 4) == 0 && h->version == JIR_VERSION &&
+              (h->flags & ~JIR_HAS_SOURCE) == 0 &&
+              h->file_size == m->size && h->index_offset >= sizeof(JirHeader) &&
+              h->index_offset % 4 == 0 &&
+              h->index_offset + (uint64_t)h->function_count * sizeof(JirFunctionEntry) <= h->strtab_offset &&
+              h->strtab_offset <= h->code_offset && h->code_offset <= m->size;
+
+    // Every name must start inside the string table and end with a NUL before the code
+    if (ok) {
+        m->index = (const JirFunctionEntry*)(m->base + h->index_offset);
+        for (uint32_t i = 0; ok && i < h->function_count; i++) ok = in_strtab(m, m->index[i].name_offset);
+        if (ok && (h->flags & JIR_HAS_SOURCE)) ok = in_strtab(m, h->source_offset);
+    }
+
+    if (!ok) {
+        fprintf(stderr, "Error: %s is not a valid JIR v%d file\n", path, JIR_VERSION);
+        jir_close(m);
+        return false;
+    }
+    return true;
+}
+
+void jir_close(JirModule* m) {
+    if (m->base) munmap((void*)m->base, m->size);
+    memset(m, 0, sizeof *m);
+}
+
+const char* jir_function_name(const JirModule* m, int i) {
+    return (const char*)(m->base + m->header->strtab_offset + m->index[i].name_offset);
+}
+
+const char* jir_source_path(const JirModule* m) {
+    if (!(m->header->flags & JIR_HAS_SOURCE)) return NULL;
+    return (const char*)(m->base + m->header->strtab_offset + m->header->source_offset);
+}
+
+const uint8_t* jir_function_code(const JirModule* m, int i) {
+    return m->base + m->header->code_offset + m->index[i].code_offset;
+}
+
+bool jir_decode(const uint8_t** pc, const uint8_t* end, IR* out) {
+    if (*pc >= end || **pc >= IR_OP_COUNT) return false;
+    out->op = (IROp)*(*pc)++;
+    out->imm = 0;
+    return !jir_op_has_imm(out->op) || get_varint(pc, end, &out->imm);
+}
+
+bool jir_load_function(const JirModule* m, int i, IRList* out) {
+    const JirFunctionEntry* e = &m->index[i];
+    if (e->code_offset + (uint64_t)e->code_size > m->header->file_size - m->header->code_offset)
+        return false;
+
+    const uint8_t* pc = jir_function_code(m, i);
+    const uint8_t* end = pc + e->code_size;
+    for (uint32_t k = 0; k < e->insn_count; k++) {
+        IR instr;
+        if (!jir_decode(&pc, end, &instr)) return false;
+        ir_emit(out, instr.op, instr.imm);
+    }
+    return pc == end;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "stack_machine_ir.h"
+
+// ==========================================================
+// JIR: compact on-disk IR (.jir)
+//
+// Layout (little-endian, every section 4-byte aligned):
+//   JirHeader                      at offset 0
+//   JirFunctionEntry[count]        at header.index_offset
+//   string table (NUL-terminated)  at header.strtab_offset
+//                                  (function names, then the source path)
+//   encoded code                   at header.code_offset
+//
+// Each instruction is one opcode byte (the IROp value), followed by a
+// zigzag LEB128 immediate for ops that carry one (see jir_op_has_imm).
+// The header and index are used in place after mmap; only the code
+// bytes are decoded, one instruction at a time.
+// ==========================================================
+
+#define JIR_MAGIC   "JIR\0"
+#define JIR_VERSION 1
+
+// header.flags
+#define JIR_HAS_SOURCE 0x1  // source_offset names the source file
+
+typedef struct {
+    char     magic[4];        // "JIR\0"
+    uint16_t version;         // JIR_VERSION
+    uint16_t flags;           // JIR_HAS_SOURCE, other bits 0
+    uint32_t function_count;
+    uint32_t index_offset;
+    uint32_t strtab_offset;
+    uint32_t code_offset;
+    uint32_t file_size;
+    uint32_t source_offset;   // into string table, if JIR_HAS_SOURCE
+} JirHeader;
+
+typedef struct {
+    uint32_t name_offset;     // into string table
+    uint32_t code_offset;     // into code section
+    uint32_t code_size;       // encoded bytes
+    uint32_t insn_count;      // decoded instructions
+    int32_t  frame_size;      // aligned local bytes (sub rsp, N)
+    uint32_t reserved;
+} JirFunctionEntry;
+
+// ---------- Writing ----------
+typedef struct {
+    const char* name;
+    IRList*     ir;
+    int         frame_size;
+} JirFunctionDesc;
+
+// source (may be NULL) is recorded as the module's source file, for
+// --instrument on the .jir. Scratch buffers come from A (NULL: system
+// allocator).
+bool jir_write_file(const char* path, const JirFunctionDesc* fns, int count,
+                    const char* source, Allocator* A);
+
+// ---------- Reading (mmap) ----------
+typedef struct {
+    const uint8_t*          base;
+    size_t                  size;
+    const JirHeader*        header;
+    const JirFunctionEntry* index;
+} JirModule;
+
+// Maps the file and checks the header, section bounds and that every
+// function name (and the source path) is a NUL-terminated string inside
+// the string table.
+bool jir_open(JirModule* m, const char* path);
+void jir_close(JirModule* m);
+
+const char* jir_function_name(const JirModule* m, int i);
+const char* jir_source_path(const JirModule* m);  // NULL if not recorded
+const uint8_t* jir_function_code(const JirModule* m, int i);
+
+// Decode one instruction at *pc and advance it. Fails on an unknown
+// opcode or an encoding that runs past end.
+bool jir_decode(const uint8_t** pc, const uint8_t* end, IR* out);
+
+// Decode a whole function into an IRList (for stack_machine_emit).
+bool jir_load_function(const JirModule* m, int i, IRList* out);
+
+bool jir_op_has_imm(IROp op);
@@ -41,14 +41,18 @@ static void skip_ws(Lexer* L) {
     }
 }
 
-// Create a token for keyword or identifier
-static Token make_kw_or_ident(const char* text, int line) {
-    if (strcmp(text, "fn") == 0) return (Token){T_FN, strdup(text), 0, line};
-    if (strcmp(text, "return") == 0) return (Token){T_RETURN, strdup(text), 0, line};
-    if (strcmp(text, "let") == 0) return (Token){T_LET, strdup(text), 0, line};
-    if (strcmp(text, "set") == 0) return (Token){T_SET, strdup(text), 0, line};
-    if (strcmp(text, "int") == 0) return (Token){T_INT_TYPE, strdup(text), 0, line};
-    return (Token){T_IDENTIFIER, strdup(text), 0, line};
+// Create a token for keyword or identifier (text is owned by L->strings)
+static Token make_kw_or_ident(char* text, int line) {
+    if (strcmp(text, "fn") == 0) return (Token){T_FN, text, 0, line};
+    if (strcmp(text, "export") == 0) return (Token){T_EXPORT, text, 0, line};
+    if (strcmp(text, "if") == 0) return (Token){T_IF, text, 0, line};
+    if (strcmp(text, "else") == 0) return (Token){T_ELSE, text, 0, line};
+    if (strcmp(text, "while") == 0) return (Token){T_WHILE, text, 0, line};
+    if (strcmp(text, "return") == 0) return (Token){T_RETURN, text, 0, line};
+    if (strcmp(text, "let") == 0) return (Token){T_LET, text, 0, line};
+    if (strcmp(text, "set") == 0) return (Token){T_SET, text, 0, line};
+    if (strcmp(text, "int") == 0) return (Token){T_INT_TYPE, text, 0, line};
+    return (Token){T_IDENTIFIER, text, 0, line};
 }
 
 // Create a token for number literals
@@ -56,17 +60,25 @@ static Token make_number(Lexer* L) {
     int start = L->pos;
     while (isdigit(peek(L))) advance(L);
     int len = L->pos - start;
-    char* text = strndup(L->src + start, len);
+    char* text = mem_strndup(L->strings, L->src + start, len);
     return (Token){T_INT_LITERAL, text, atoi(text), L->line};
 }
 
 // Initialize lexer
-void init_lexer(Lexer* L, const char* src) {
+void init_lexer(Lexer* L, const char* src, Allocator* A) {
     L->src = src;
     L->pos = 0;
     L->line = 1;
     L->current = (Token){T_INVALID, NULL, 0, 1};
     L->last_identifier[0] = '\0';
+    L->A = A ? A : alloc_system();
+    L->strings = arena_new(L->A, 4096);
+}
+
+// Release all token text produced by this lexer
+void free_lexer(Lexer* L) {
+    arena_destroy(L->strings);
+    L->strings = NULL;
 }
 
 // Produce the next token
@@ -75,8 +87,10 @@ Token next_token(Lexer* L) {
     int line = L->line;
     char c = advance(L);
 
+#ifdef LEXER_DEBUG
     // Debug: show each raw character
     printf("[DEBUG] CHAR: '%c' (ASCII %d) at line %d\n", c, (int)c, line);
+#endif
 
     // End of file
     if (c == '\0')
@@ -107,11 +121,35 @@ Token next_token(Lexer* L) {
         case '%':
             return (Token){T_PERCENT, "%", 0, line};
         case '=':
+            if (peek(L) == '=') {
+                advance(L);
+                return (Token){T_EQUAL_EQUAL, "==", 0, line};
+            }
             return (Token){T_EQUAL, "=", 0, line};
+        case '!':
+            if (peek(L) == '=') {
+                advance(L);
+                return (Token){T_BANG_EQUAL, "!=", 0, line};
+            }
+            break;
+        case '<':
+            if (peek(L) == '=') {
+                advance(L);
+                return (Token){T_LESS_EQUAL, "<=", 0, line};
+            }
+            return (Token){T_LESS, "<", 0, line};
+        case '>':
+            if (peek(L) == '=') {
+                advance(L);
+                return (Token){T_GREATER_EQUAL, ">=", 0, line};
+            }
+            return (Token){T_GREATER, ">", 0, line};
         case ';':
             return (Token){T_SEMICOLON, ";", 0, line};
         case ':':
             return (Token){T_COLON, ":", 0, line};
+        case ',':
+            return (Token){T_COMMA, ",", 0, line};
     }
 
     // Identifiers / keywords
@@ -119,8 +157,8 @@ Token next_token(Lexer* L) {
         int start = L->pos - 1;
         while (isalnum(peek(L))) advance(L);
         int len = L->pos - start;
-        char* text = strndup(L->src + start, len);
-        strcpy(L->last_identifier, text);
+        char* text = mem_strndup(L->strings, L->src + start, len);
+        snprintf(L->last_identifier, sizeof L->last_identifier, "%s", text);
         return make_kw_or_ident(text, line);
     }
 
@@ -144,6 +182,10 @@ const char* token_type_to_string(TokenType t) {
         case T_LET: return "LET";
         case T_SET: return "SET";
         case T_FN: return "FN";
+        case T_EXPORT: return "EXPORT";
+        case T_IF: return "IF";
+        case T_ELSE: return "ELSE";
+        case T_WHILE: return "WHILE";
         case T_LPAREN: return "LPAREN";
         case T_RPAREN: return "RPAREN";
         case T_LBRACE: return "LBRACE";
@@ -154,8 +196,15 @@ const char* token_type_to_string(TokenType t) {
         case T_SLASH: return "SLASH";
         case T_PERCENT: return "PERCENT";
         case T_EQUAL: return "EQUAL";
+        case T_EQUAL_EQUAL: return "EQUAL_EQUAL";
+        case T_BANG_EQUAL: return "BANG_EQUAL";
+        case T_LESS: return "LESS";
+        case T_LESS_EQUAL: return "LESS_EQUAL";
+        case T_GREATER: return "GREATER";
+        case T_GREATER_EQUAL: return "GREATER_EQUAL";
         case T_SEMICOLON: return "SEMICOLON";
         case T_COLON: return "COLON";
+        case T_COMMA: return "COMMA";
         case T_ARROW: return "ARROW";
         case T_INVALID: return "INVALID";
         default: return "UNKNOWN";
@@ -165,7 +214,7 @@ const char* token_type_to_string(TokenType t) {
 // Debug function to print all tokens
 void debug_print_tokens(const char* src) {
     Lexer L;
-    init_lexer(&L, src);
+    init_lexer(&L, src, NULL);
 
     Token t;
     printf("[DEBUG] ---- TOKEN STREAM ----\n");
@@ -174,4 +223,5 @@ void debug_print_tokens(const char* src) {
         printf("[DEBUG] %-12s  (%s)\n", token_type_to_string(t.type), t.text ? t.text : "NULL");
     } while (t.type != T_EOF);
     printf("[DEBUG] -----------------------\n");
+    free_lexer(&L);
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "alloc.h"
 
 typedef enum {
     T_EOF,
@@ -16,6 +17,10 @@ typedef enum {
     T_LET,
     T_SET,
     T_FN,
+    T_EXPORT,
+    T_IF,
+    T_ELSE,
+    T_WHILE,
     T_LPAREN,
     T_RPAREN,
     T_LBRACE,
@@ -26,8 +31,15 @@ typedef enum {
     T_SLASH,
     T_PERCENT,
     T_EQUAL,
+    T_EQUAL_EQUAL,   // ==
+    T_BANG_EQUAL,    // !=
+    T_LESS,          // <
+    T_LESS_EQUAL,    // <=
+    T_GREATER,       // >
+    T_GREATER_EQUAL, // >=
     T_SEMICOLON,
     T_COLON,
+    T_COMMA,
     T_ARROW,
     T_INVALID
 } TokenType;
@@ -45,9 +57,12 @@ typedef struct {
     int line;
     Token current;
     char last_identifier[128];
+    Allocator* A;        // allocator for everything built from this source
+    Allocator* strings;  // arena owning token text, freed by free_lexer
 } Lexer;
 
-void init_lexer(Lexer* L, const char* src);
+void init_lexer(Lexer* L, const char* src, Allocator* A);
+void free_lexer(Lexer* L);
 Token next_token(Lexer* L);
 const char* token_type_to_string(TokenType t);
 
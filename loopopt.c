@@ -0,0 +1,408 @@
+#include "loopopt.h"
+#include "cfg.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ----------------------------------------------------------
+// Per-loop state
+// ----------------------------------------------------------
+
+// One operand-stack entry during simulation: where its code starts and
+// whether its value is the same on every iteration
+typedef struct {
+    int start;
+    bool inv;
+} Operand;
+
+// Replace ir[start, end) by IR_LOAD offset
+typedef struct {
+    int start;
+    int end;
+    int offset;
+} Rewrite;
+
+// After the store at `pos`: t = t + step
+typedef struct {
+    int pos;
+    int offset;
+    int step;
+} Update;
+
+// A store i = i + step inside the loop
+typedef struct {
+    int pos;
+    int slot;
+    long long step;
+} IvStore;
+
+// A use i * k inside the loop: ir[start, start + 3)
+typedef struct {
+    int start;
+    int slot;
+    int k;
+} IvUse;
+
+typedef struct {
+    const IRList* ir;
+    int first;           // IR range of the loop [first, last)
+    int last;
+    bool* stored;        // per slot: stored inside the loop
+    bool* iv_ok;         // per slot: every store is i = i +/- c
+    int slot_count;
+    int next_offset;     // last frame slot handed out
+
+    IRList pre;          // preheader code
+
+    Rewrite* rw;
+    int nrw, caprw;
+    Update* upd;
+    int nupd, capupd;
+    IvStore* stores;
+    int nstores, capstores;
+    IvUse* uses;
+    int nuses, capuses;
+} LoopCtx;
+
+#define PUSH_BACK(A, arr, n, cap, value)                              \
+    do {                                                              \
+        if ((n) == (cap)) {                                           \
+            (cap) = (cap) ? (cap) * 2 : 8;                            \
+            (arr) = mem_realloc((A), (arr), sizeof(*(arr)) * (cap));  \
+        }                                                             \
+        (arr)[(n)++] = (value);                                       \
+    } while (0)
+
+static int slot_of(int offset) {
+    return offset / 8 - 1;
+}
+
+static bool is_pure_binop(IROp op) {
+    switch (op) {
+        case IR_ADD: case IR_SUB: case IR_MUL: case IR_SUB_R:
+        case IR_LT: case IR_LE: case IR_GT: case IR_GE: case IR_EQ: case IR_NE:
+        case IR_DIV: case IR_MOD: case IR_DIV_R: case IR_MOD_R:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool is_constant_divisor(const IRList* ir, int start, int end) {
+    if (end - start != 1 || ir->code[start].op != IR_PUSH_INT) return false;
+    return ir->code[start].imm != 0 && ir->code[start].imm != -1;
+}
+
+static bool same_code(const IRList* ir, int a, int b, int len) {
+    for (int i = 0; i < len; i++) {
+        if (ir->code[a + i].op != ir->code[b + i].op || ir->code[a + i].imm != ir->code[b + i].imm)
+            return false;
+    }
+    return true;
+}
+
+static int new_slot(LoopCtx* c) {
+    c->next_offset += 8;
+    return c->next_offset;
+}
+
+// ----------------------------------------------------------
+// Analysis: simulate the operand stack of each block
+// ----------------------------------------------------------
+
+// An invariant operand consumed by variant code: hoist it if it does
+// any work (a lone constant or load gains nothing)
+static void consider(LoopCtx* c, Operand o, int end) {
+    if (o.inv && end - o.start >= 3) PUSH_BACK(c->ir->A, c->rw, c->nrw, c->caprw, ((Rewrite){ o.start, end, 0 }));
+}
+
+// Record i = i + c for a store to `slot` at pos whose value starts at `start`
+static void note_store(LoopCtx* c, int pos, int start, int slot) {
+    const IR* code = c->ir->code;
+    if (pos - start == 3 && (code[pos - 1].op == IR_ADD || code[pos - 1].op == IR_SUB)) {
+        IR x = code[pos - 3], y = code[pos - 2];
+        bool add = code[pos - 1].op == IR_ADD;
+        long long step = 0;
+        bool ok = false;
+        if (x.op == IR_LOAD && slot_of(x.imm) == slot && y.op == IR_PUSH_INT) {
+            step = add ? y.imm : -(long long)y.imm;
+            ok = true;
+        } else if (add && y.op == IR_LOAD && slot_of(y.imm) == slot && x.op == IR_PUSH_INT) {
+            step = x.imm;
+            ok = true;
+        }
+        if (ok) {
+            PUSH_BACK(c->ir->A, c->stores, c->nstores, c->capstores, ((IvStore){ pos, slot, step }));
+            return;
+        }
+    }
+    c->iv_ok[slot] = false;
+}
+
+static void scan_block(LoopCtx* c, int start, int end, Operand* stack) {
+    const IR* code = c->ir->code;
+    int sp = 0;
+    for (int i = start; i < end; i++) {
+        IR in = code[i];
+        switch (in.op) {
+            case IR_PUSH_INT:
+                stack[sp++] = (Operand){ i, true };
+                break;
+            case IR_LOAD:
+                stack[sp++] = (Operand){ i, !c->stored[slot_of(in.imm)] };
+                break;
+            case IR_PARAM:
+            case IR_CALL:
+                stack[sp++] = (Operand){ i, false };
+                break;
+            case IR_STORE: {
+                Operand a = stack[--sp];
+                consider(c, a, i);
+                note_store(c, i, a.start, slot_of(in.imm));
+                break;
+            }
+            case IR_ARG:
+            case IR_JZ:
+            case IR_RET:
+                consider(c, stack[--sp], i);
+                break;
+            default: {
+                if (!is_pure_binop(in.op)) break;  // LINE, LABEL, JMP
+                Operand b = stack[--sp];
+                Operand a = stack[--sp];
+                bool safe = true;
+                if (in.op == IR_DIV || in.op == IR_MOD) safe = is_constant_divisor(c->ir, b.start, i);
+                if (in.op == IR_DIV_R || in.op == IR_MOD_R) safe = is_constant_divisor(c->ir, a.start, b.start);
+                Operand r = { a.start, a.inv && b.inv && safe };
+                if (!r.inv) {
+                    consider(c, a, b.start);
+                    consider(c, b, i);
+                }
+                if (in.op == IR_MUL && a.start == i - 2 && b.start == i - 1) {
+                    IR x = code[i - 2], y = code[i - 1];
+                    if (x.op == IR_LOAD && y.op == IR_PUSH_INT)
+                        PUSH_BACK(c->ir->A, c->uses, c->nuses, c->capuses, ((IvUse){ i - 2, slot_of(x.imm), y.imm }));
+                    else if (y.op == IR_LOAD && x.op == IR_PUSH_INT)
+                        PUSH_BACK(c->ir->A, c->uses, c->nuses, c->capuses, ((IvUse){ i - 2, slot_of(y.imm), x.imm }));
+                }
+                stack[sp++] = r;
+                break;
+            }
+        }
+    }
+}
+
+static void analyze(LoopCtx* c, const CFG* g, int header, int latch) {
+    for (int i = c->first; i < c->last; i++) {
+        if (c->ir->code[i].op == IR_STORE) c->stored[slot_of(c->ir->code[i].imm)] = true;
+    }
+    // codegen leaves the operand stack empty between blocks
+    Operand* stack = mem_alloc(c->ir->A, sizeof(Operand) * (c->last - c->first + 1));
+    for (int k = header; k <= latch; k++) scan_block(c, g->blocks[k].start, g->blocks[k].end, stack);
+    mem_free(c->ir->A, stack);
+}
+
+// ----------------------------------------------------------
+// Transformations
+// ----------------------------------------------------------
+
+static void plan_hoists(LoopCtx* c, LoopOptStats* st) {
+    for (int r = 0; r < c->nrw; r++) {
+        Rewrite* w = &c->rw[r];
+        int len = w->end - w->start;
+        // the same expression computed earlier in the loop shares its slot
+        for (int q = 0; q < r && !w->offset; q++) {
+            const Rewrite* v = &c->rw[q];
+            if (v->end - v->start == len && same_code(c->ir, v->start, w->start, len)) w->offset = v->offset;
+        }
+        if (w->offset) continue;
+
+        w->offset = new_slot(c);
+        for (int i = w->start; i < w->end; i++) ir_emit(&c->pre, c->ir->code[i].op, c->ir->code[i].imm);
+        ir_emit(&c->pre, IR_STORE, w->offset);
+        st->hoisted++;
+    }
+}
+
+static void plan_reductions(LoopCtx* c, LoopOptStats* st) {
+    bool* done = mem_alloc(c->ir->A, sizeof(bool) * (c->nuses + 1));
+    for (int u = 0; u < c->nuses; u++) {
+        if (done[u]) continue;
+        int slot = c->uses[u].slot;
+        int k = c->uses[u].k;
+        if (!c->stored[slot] || !c->iv_ok[slot]) continue;
+
+        // all uses of this (i, k), and the steps of every store to i
+        int uses = 0, stores = 0;
+        bool fits = true;
+        for (int v = u; v < c->nuses; v++) {
+            if (c->uses[v].slot == slot && c->uses[v].k == k) uses++;
+        }
+        for (int s = 0; s < c->nstores; s++) {
+            if (c->stores[s].slot != slot) continue;
+            stores++;
+            long long step = c->stores[s].step * k;
+            if (step < INT_MIN || step > INT_MAX) fits = false;
+        }
+        if (!fits || uses < 2 * stores) continue;
+
+        int t = new_slot(c);
+        ir_emit(&c->pre, IR_LOAD, (slot + 1) * 8);
+        ir_emit(&c->pre, IR_PUSH_INT, k);
+        ir_emit(&c->pre, IR_MUL, 0);
+        ir_emit(&c->pre, IR_STORE, t);
+        for (int v = u; v < c->nuses; v++) {
+            if (c->uses[v].slot != slot || c->uses[v].k != k) continue;
+            done[v] = true;
+            int start = c->uses[v].start;
+            PUSH_BACK(c->ir->A, c->rw, c->nrw, c->caprw, ((Rewrite){ start, start + 3, t }));
+            st->reduced++;
+        }
+        for (int s = 0; s < c->nstores; s++) {
+            if (c->stores[s].slot != slot) continue;
+            Update up = { c->stores[s].pos, t, (int)(c->stores[s].step * k) };
+            PUSH_BACK(c->ir->A, c->upd, c->nupd, c->capupd, up);
+        }
+    }
+    mem_free(c->ir->A, done);
+}
+
+static int cmp_rewrite(const void* a, const void* b) {
+    return ((const Rewrite*)a)->start - ((const Rewrite*)b)->start;
+}
+
+static int cmp_update(const void* a, const void* b) {
+    return ((const Update*)a)->pos - ((const Update*)b)->pos;
+}
+
+// Rebuild the function: preheader before the header's label, rewrites
+// in place, induction updates after their stores
+static void apply(LoopCtx* c, IRList* out) {
+    if (c->nrw) qsort(c->rw, c->nrw, sizeof(Rewrite), cmp_rewrite);
+    if (c->nupd) qsort(c->upd, c->nupd, sizeof(Update), cmp_update);
+    const IRList* ir = c->ir;
+    int r = 0, u = 0;
+    for (int i = 0; i < ir->count; i++) {
+        if (i == c->first) {
+            for (int k = 0; k < c->pre.count; k++) ir_emit(out, c->pre.code[k].op, c->pre.code[k].imm);
+        }
+        if (r < c->nrw && c->rw[r].start == i) {
+            ir_emit(out, IR_LOAD, c->rw[r].offset);
+            i = c->rw[r++].end - 1;
+            continue;
+        }
+        ir_emit(out, ir->code[i].op, ir->code[i].imm);
+        for (; u < c->nupd && c->upd[u].pos == i; u++) {
+            ir_emit(out, IR_LOAD, c->upd[u].offset);
+            ir_emit(out, IR_PUSH_INT, c->upd[u].step);
+            ir_emit(out, IR_ADD, 0);
+            ir_emit(out, IR_STORE, c->upd[u].offset);
+        }
+    }
+}
+
+// ----------------------------------------------------------
+// Driver
+// ----------------------------------------------------------
+
+// Is the loop the contiguous block range [header, latch], entered from
+// outside only by falling into the header? An early `return` inside the
+// body is a block in the range with no successors: it cannot reach the
+// latch, so it is not in the natural loop, but it runs at most once per
+// entry and only after the preheader, so it is scanned with the loop.
+static bool well_formed(const IRList* ir, const CFG* g, const Loop* L) {
+    for (int k = 0; k < g->count; k++) {
+        bool inside = k >= L->header && k <= L->latch;
+        bool exits = inside && g->blocks[k].nsucc == 0;
+        if (L->body[k] != inside && !exits) return false;
+        if (inside) continue;
+        const BasicBlock* b = &g->blocks[k];
+        IROp last = ir->code[b->end - 1].op;
+        bool falls = last != IR_JMP && last != IR_RET;
+        for (int s = 0; s < b->nsucc; s++) {
+            bool fall_edge = falls && s == 0 && k + 1 == b->succ[s];
+            if (b->succ[s] == L->header && !fall_edge) return false;
+            if (b->succ[s] > L->header && b->succ[s] <= L->latch) return false;
+        }
+    }
+    return true;
+}
+
+static bool optimize_loop(IRList* ir, const CFG* g, const Loop* L, int* next_offset,
+                          LoopOptStats* st) {
+    int slots = 0;
+    for (int i = 0; i < ir->count; i++) {
+        if ((ir->code[i].op == IR_LOAD || ir->code[i].op == IR_STORE) && slot_of(ir->code[i].imm) >= slots)
+            slots = slot_of(ir->code[i].imm) + 1;
+    }
+
+    LoopCtx c = { .ir = ir, .first = g->blocks[L->header].start, .last = g->blocks[L->latch].end,
+                  .slot_count = slots, .next_offset = *next_offset };
+    c.stored = mem_alloc(ir->A, sizeof(bool) * (slots + 1));
+    c.iv_ok = mem_alloc(ir->A, sizeof(bool) * (slots + 1));
+    for (int s = 0; s < slots; s++) c.iv_ok[s] = true;
+    ir_init(&c.pre, ir->A);
+
+    analyze(&c, g, L->header, L->latch);
+    plan_hoists(&c, st);
+    plan_reductions(&c, st);
+
+    bool changed = c.pre.count > 0;
+    if (changed) {
+        IRList out;
+        ir_init(&out, ir->A);
+        apply(&c, &out);
+        ir_free(ir);
+        *ir = out;
+        *next_offset = c.next_offset;
+    }
+
+    ir_free(&c.pre);
+    mem_free(ir->A, c.stored);
+    mem_free(ir->A, c.iv_ok);
+    mem_free(ir->A, c.rw);
+    mem_free(ir->A, c.upd);
+    mem_free(ir->A, c.stores);
+    mem_free(ir->A, c.uses);
+    return changed;
+}
+
+LoopOptStats loop_optimize(IRList* ir, int* frame_bytes) {
+    LoopOptStats st = {0};
+    int next_offset = *frame_bytes;
+    bool* seen = NULL;  // per header label: already optimized
+    int seen_count = 0;
+
+    for (;;) {
+        // Rebuild after every change; pick the innermost (shortest) loop left
+        CFG g;
+        cfg_build(&g, ir);
+        if (g.label_count > seen_count) {
+            seen = mem_realloc(ir->A, seen, sizeof(bool) * g.label_count);
+            memset(seen + seen_count, 0, sizeof(bool) * (g.label_count - seen_count));
+            seen_count = g.label_count;
+        }
+        int nloops;
+        Loop* loops = cfg_find_loops(&g, &nloops);
+        const Loop* best = NULL;
+        for (int i = 0; i < nloops; i++) {
+            const Loop* L = &loops[i];
+            int label = g.blocks[L->header].label;
+            if (label < 0 || seen[label]) continue;
+            int span = g.blocks[L->latch].end - g.blocks[L->header].start;
+            if (!best || span < g.blocks[best->latch].end - g.blocks[best->header].start) best = L;
+        }
+        if (best) {
+            seen[g.blocks[best->header].label] = true;
+            if (!well_formed(ir, &g, best)) st.skipped++;
+            else if (optimize_loop(ir, &g, best, &next_offset, &st)) st.loops++;
+        }
+        cfg_free_loops(&g, loops, nloops);
+        cfg_free(&g);
+        if (!best) break;
+    }
+
+    mem_free(ir->A, seen);
+    *frame_bytes = (next_offset + 15) & ~15;
+    return st;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "stack_machine_ir.h"
+
+// Loop optimizations on the CFG of one function's IR, innermost loop
+// first. Each loop gets a preheader: code inserted just before the
+// header's label, which runs once on entry (codegen only reaches a loop
+// header by falling into it or by its own back edge).
+//
+// - Loop-invariant code motion: a maximal pure subexpression whose
+//   leaves are constants or slots the loop never stores to is computed
+//   in the preheader into a fresh frame slot, and the loop loads that.
+//   Only code that cannot fault is moved (no calls; a divisor must be a
+//   constant other than 0 and -1), since the loop may run zero times.
+// - Strength reduction: for a basic induction variable i (every store
+//   in the loop is i = i +/- c), each i * k becomes a load of a slot t
+//   kept equal to i * k: t = i * k in the preheader, t = t + c * k
+//   after every store to i. Applied when the product is used at least
+//   twice per store to i (each store costs four instructions, each use
+//   saves a push and an imul).
+//
+// New slots are added past *frame_bytes, which is updated (16-aligned).
+typedef struct {
+    int loops;    // loops optimized
+    int hoisted;  // invariant expressions moved to a preheader
+    int reduced;  // i * k products replaced by a running sum
+    int skipped;  // loops not in the shape above (not a contiguous range, or entered mid-body)
+} LoopOptStats;
+
+LoopOptStats loop_optimize(IRList* ir, int* frame_bytes);
@@ -1,26 +1,167 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "lexer.h"
 #include "parser.h"
 #include "symbol_table.h"
 #include "codegen.h"
+#include "passes.h"
 #include "stack_machine_ir.h"
 #include "stack_machine.h"
+#include "jir.h"
 
 // Global symbol stack
 SymStack* g_symstack = NULL;
 
+static bool has_extension(const char* path, const char* ext) {
+    size_t n = strlen(path), m = strlen(ext);
+    return n >= m && strcmp(path + n - m, ext) == 0;
+}
+
+// Switch the tracking allocator (if any) to a new phase
+static void set_phase(Allocator* tracker, const char* phase) {
+    if (tracker) tracking_set_phase(tracker, phase);
+}
+
+// Back-end only: <input.jir> -> <output.asm>
+static int compile_jir(PassManager* pm, Allocator* A, Allocator* tracker, const char* input_path,
+                       const char* output_path, bool instrument, bool regalloc, bool size_report) {
+    set_phase(tracker, "load");
+    JirModule m;
+    if (!jir_open(&m, input_path)) {
+        fprintf(stderr, "Error: cannot load IR file %s\n", input_path);
+        return 1;
+    }
+
+    FILE* out = fopen(output_path, "w");
+    if (!out) {
+        fprintf(stderr, "Error: cannot open output file %s\n", output_path);
+        jir_close(&m);
+        return 1;
+    }
+
+    // IR_CALL targets are indices into the module's function index
+    int count = (int)m.header->function_count;
+    const char** names = mem_alloc(A, sizeof(char*) * (count + 1));
+    for (int i = 0; i < count; i++) names[i] = jir_function_name(&m, i);
+    stack_machine_set_callees(names, count);
+    stack_machine_set_instrument(instrument);
+    stack_machine_set_regalloc(regalloc);
+
+    for (int i = 0; i < count; i++) {
+        set_phase(tracker, "load");
+        IRList ir;
+        ir_init(&ir, A);
+        if (!jir_load_function(&m, i, &ir)) {
+            fprintf(stderr, "Error: corrupt code for function %s\n", jir_function_name(&m, i));
+            ir_free(&ir);
+            mem_free(A, names);
+            fclose(out);
+            jir_close(&m);
+            return 1;
+        }
+        set_phase(tracker, "emit");
+        int frame = (int)m.index[i].frame_size;
+        pm_run_ir(pm, jir_function_name(&m, i), &ir, &frame);
+        stack_machine_emit(out, jir_function_name(&m, i), &ir, frame);
+        ir_free(&ir);
+    }
+    // Profile against the module's source; without one, jive_prof needs the path
+    if (instrument) {
+        const char* source = jir_source_path(&m);
+        if (!source) fprintf(stderr, "warning: %s records no source file; pass it to jive_prof\n", input_path);
+        stack_machine_emit_profile_data(out, source ? source : "");
+    }
+    set_phase(tracker, "shutdown");
+    mem_free(A, names);
+    fclose(out);
+    jir_close(&m);
+    pm_print_stats(pm, stdout);
+    if (size_report) printf("Code size: %ld bytes\n", stack_machine_code_bytes());
+
+    printf("✅ Compilation successful!\n");
+    printf("Generated assembly: %s\n", output_path);
+    return 0;
+}
+
+// --mem-stats report, then drop the tracker and arena
+static void release_allocators(Allocator* tracker, Allocator* arena) {
+    if (tracker) {
+        tracking_report(tracker, stderr);
+        long leaks = tracking_report_leaks(tracker, stderr);
+        fprintf(stderr, "%ld leaked block(s)\n", leaks);
+        tracking_destroy(tracker);
+    }
+    arena_destroy(arena);
+}
+
 int main(int argc, char** argv) {
-    if (argc < 3) {
-        fprintf(stderr, "Usage: %s <input.jive> <output.asm>\n", argv[0]);
+    // ---------- Options ----------
+    bool flat_ast = false;
+    bool use_arena = false;
+    bool mem_stats = false;
+    bool instrument = false;
+    bool regalloc = false;
+    bool depth_report = false;
+    bool size_opt = false;
+    bool size_report = false;
+    const char* paths[2] = { NULL, NULL };
+    int npaths = 0;
+
+    PassManager pm;
+    pm_init(&pm);
+
+    for (int i = 1; i < argc; i++) {
+        if (pm_parse_option(&pm, argv[i])) {
+            continue;
+        } else if (strcmp(argv[i], "--flat-ast") == 0) {
+            flat_ast = true;
+        } else if (strcmp(argv[i], "--arena") == 0) {
+            use_arena = true;
+        } else if (strcmp(argv[i], "--mem-stats") == 0) {
+            mem_stats = true;
+        } else if (strcmp(argv[i], "--instrument") == 0) {
+            instrument = true;
+        } else if (strcmp(argv[i], "--regalloc") == 0) {
+            regalloc = true;
+        } else if (strcmp(argv[i], "--depth-report") == 0) {
+            depth_report = true;
+        } else if (strcmp(argv[i], "-Os") == 0) {
+            size_opt = size_report = true;
+        } else if (strcmp(argv[i], "--size-report") == 0) {
+            size_report = true;
+        } else if (npaths < 2) {
+            paths[npaths++] = argv[i];
+        }
+    }
+
+    if (npaths < 2) {
+        fprintf(stderr, "Usage: %s [-O0|-O1|-O2] [-passes=P,...] [-disable-pass=P,...] [--time-passes] "
+                        "[--flat-ast] [--inline-report] [--loop-report] [--dce-report] [--arena] [--mem-stats] [--instrument] "
+                        "[--regalloc] [--depth-report] [-Os] [--size-report] <input.jive> <output.asm|output.jir>\n", argv[0]);
+        fprintf(stderr, "       %s [IR pass options] [--arena] [--mem-stats] [--instrument] [--regalloc] [-Os] [--size-report] <input.jir> <output.asm>\n", argv[0]);
+        fprintf(stderr, "Passes: %s\n", pm_pass_names());
         return 1;
     }
 
-    const char* input_path  = argv[1];
-    const char* output_path = argv[2];
+    const char* input_path  = paths[0];
+    const char* output_path = paths[1];
+
+    // ---------- Allocator: system or arena, optionally tracked ----------
+    Allocator* arena = use_arena ? arena_new(NULL, 0) : NULL;
+    Allocator* tracker = mem_stats ? tracking_new(arena) : NULL;
+    Allocator* A = tracker ? tracker : (arena ? arena : alloc_system());
+
+    stack_machine_set_size_opt(size_opt);
+    if (has_extension(input_path, ".jir")) {
+        int status = compile_jir(&pm, A, tracker, input_path, output_path, instrument, regalloc, size_report);
+        release_allocators(tracker, arena);
+        return status;
+    }
 
     // Initialize global symbol stack
-    g_symstack = symstack_new();
+    set_phase(tracker, "read");
+    g_symstack = symstack_new(A);
 
     // ---------- Step 1: Read source ----------
     FILE* f = fopen(input_path, "r");
@@ -32,48 +173,105 @@ int main(int argc, char** argv) {
     long len = ftell(f);
     fseek(f, 0, SEEK_SET);
 
-    char* src = malloc(len + 1);
+    char* src = mem_alloc(A, len + 1);
     fread(src, 1, len, f);
     src[len] = '\0';
     fclose(f);
 
-    // ---------- Step 2: Initialize lexer & parser ----------
-    Lexer lexer;
-    init_lexer(&lexer, src);
-
+    // ---------- Step 2: Initialize parser ----------
+    set_phase(tracker, "parse");
     Parser parser;
-    init_parser(&parser, src);
+    init_parser(&parser, src, A);
 
-    Function* fn = parse_function(&parser);
-    if (!fn) {
-        fprintf(stderr, "Error: parsing failed.\n");
-        free(src);
-        symstack_free(g_symstack);
-        return 1;
+    // ---------- Step 3: Parse and optimize the module ----------
+    Program* prog = parse_program(&parser);
+    set_phase(tracker, "optimize");
+    pm_run_program(&pm, prog);
+    int count = prog->count;
+    int status = 0;
+
+    // ---------- Step 4: Generate IR per function ----------
+    set_phase(tracker, "codegen");
+
+    // With --flat-ast, codegen reads a flattened copy of each optimized function.
+    FlatAst* flats = NULL;
+    if (flat_ast) {
+        flats = mem_alloc(A, sizeof(FlatAst) * (count + 1));
+        for (int i = 0; i < count; i++) {
+            flat_init(&flats[i], A);
+            gen_flatten_function(prog->fns[i], &flats[i]);
+        }
     }
 
-    // ---------- Step 3: Generate IR ----------
-    IRList ir;
-    ir_init(&ir);
-    int locals_aligned = 0;
-    gen_function(fn, &ir, &locals_aligned);
+    const char** names = mem_alloc(A, sizeof(char*) * (count + 1));
+    int* params = mem_alloc(A, sizeof(int) * (count + 1));
+    int* frames = mem_alloc(A, sizeof(int) * (count + 1));
+    IRList* irs = mem_alloc(A, sizeof(IRList) * (count + 1));
 
-    // ---------- Step 4: Write assembly ----------
-    FILE* out = fopen(output_path, "w");
-    if (!out) {
-        fprintf(stderr, "Error: cannot open output file %s\n", output_path);
-        free(src);
-        symstack_free(g_symstack);
-        return 1;
+    for (int i = 0; i < count; i++) {
+        names[i] = prog->fns[i]->name;
+        params[i] = prog->fns[i]->param_count;
     }
+    gen_set_callees(names, params, count);
+    stack_machine_set_callees(names, count);
 
-    stack_machine_emit(out, fn->name, &ir, locals_aligned);
-    fclose(out);
+    for (int i = 0; i < count; i++) {
+        ir_init(&irs[i], A);
+        if (flat_ast) gen_function_flat(&flats[i], &irs[i], &frames[i]);
+        else gen_function(prog->fns[i], &irs[i], &frames[i]);
+        pm_run_ir(&pm, names[i], &irs[i], &frames[i]);
+        if (depth_report) printf("depth: %s: max operand stack %d\n", names[i], ir_max_depth(&irs[i]));
+    }
 
-    printf("✅ Compilation successful!\n");
-    printf("Generated assembly: %s\n", output_path);
+    pm_print_stats(&pm, stdout);
+
+    set_phase(tracker, "emit");
+    if (has_extension(output_path, ".jir")) {
+        // ---------- Step 5a: Write IR only (front-end split) ----------
+        JirFunctionDesc* desc = mem_alloc(A, sizeof(JirFunctionDesc) * (count + 1));
+        for (int i = 0; i < count; i++) desc[i] = (JirFunctionDesc){ names[i], &irs[i], frames[i] };
+        if (!jir_write_file(output_path, desc, count, input_path, A)) {
+            fprintf(stderr, "Error: cannot write IR file %s\n", output_path);
+            status = 1;
+        } else {
+            printf("✅ Compilation successful!\n");
+            printf("Generated IR: %s\n", output_path);
+        }
+        mem_free(A, desc);
+    } else {
+        // ---------- Step 5b: Write assembly ----------
+        FILE* out = fopen(output_path, "w");
+        if (!out) {
+            fprintf(stderr, "Error: cannot open output file %s\n", output_path);
+            status = 1;
+        } else {
+            stack_machine_set_instrument(instrument);
+            stack_machine_set_regalloc(regalloc);
+            for (int i = 0; i < count; i++) stack_machine_emit(out, names[i], &irs[i], frames[i]);
+            if (instrument) stack_machine_emit_profile_data(out, input_path);
+            fclose(out);
+            if (size_report) printf("Code size: %ld bytes\n", stack_machine_code_bytes());
+            printf("✅ Compilation successful!\n");
+            printf("Generated assembly: %s\n", output_path);
+        }
+    }
 
-    free(src);
+    // ---------- Shutdown ----------
+    set_phase(tracker, "shutdown");
+    for (int i = 0; i < count; i++) {
+        ir_free(&irs[i]);
+        if (flat_ast) flat_free(&flats[i]);
+    }
+    mem_free(A, irs);
+    mem_free(A, frames);
+    mem_free(A, params);
+    mem_free(A, names);
+    mem_free(A, flats);
+    free_program(prog);
+    free_parser(&parser);
+    mem_free(A, src);
     symstack_free(g_symstack);
-    return 0;
+
+    release_allocators(tracker, arena);
+    return status;
 }
@@ -20,13 +20,26 @@ Token expect(Parser* p, TokenType t, const char* what) {
     return tok;
 }
 
+// Statement terminator: `;` is optional (main.jive omits it)
+static void accept_semicolon(Parser* p) {
+    if (p->current.type == T_SEMICOLON) advance(p);
+}
+
 // Forward declare
 static Stmt* parse_stmt(Parser* p);
 
 // ---------- expressions ----------
 
 Expr* parse_primary(Parser* p) {
-    Expr* e = calloc(1, sizeof(Expr));
+    // ( expr )
+    if (p->current.type == T_LPAREN) {
+        advance(p);
+        Expr* inner = parse_binop(p);
+        expect(p, T_RPAREN, ")");
+        return inner;
+    }
+
+    Expr* e = mem_alloc(p->lexer.A, sizeof(Expr));
 
     if (p->current.type == T_INT_LITERAL) {
         e->kind = EXPR_INT;
@@ -38,9 +51,31 @@ Expr* parse_primary(Parser* p) {
     }
 
     if (p->current.type == T_IDENTIFIER) {
-        e->kind = EXPR_VAR;
-        e->var_name = strdup(p->current.text);
+        char* name = mem_strdup(p->lexer.A, p->current.text);
         advance(p);
+
+        // call: name(arg, ...)
+        if (p->current.type == T_LPAREN) {
+            advance(p);
+            int cap = 4;
+            e->kind = EXPR_CALL;
+            e->call.name = name;
+            e->call.args = mem_alloc(p->lexer.A, sizeof(Expr*) * cap);
+            e->call.argc = 0;
+            while (p->current.type != T_RPAREN) {
+                if (e->call.argc > 0) expect(p, T_COMMA, ",");
+                if (e->call.argc == cap) {
+                    cap *= 2;
+                    e->call.args = mem_realloc(p->lexer.A, e->call.args, sizeof(Expr*) * cap);
+                }
+                e->call.args[e->call.argc++] = parse_binop(p);
+            }
+            advance(p);
+            return e;
+        }
+
+        e->kind = EXPR_VAR;
+        e->var_name = name;
         return e;
     }
 
@@ -49,7 +84,13 @@ Expr* parse_primary(Parser* p) {
     exit(1);
 }
 
-Expr* parse_binop(Parser* p) {
+static bool is_comparison(TokenType t) {
+    return t == T_EQUAL_EQUAL || t == T_BANG_EQUAL || t == T_LESS ||
+           t == T_LESS_EQUAL || t == T_GREATER || t == T_GREATER_EQUAL;
+}
+
+// Arithmetic operators: left-associative, no precedence among them
+static Expr* parse_arith(Parser* p) {
     Expr* left = parse_primary(p);
 
     while (p->current.type == T_PLUS ||
@@ -61,7 +102,7 @@ Expr* parse_binop(Parser* p) {
         advance(p);
         Expr* right = parse_primary(p);
 
-        Expr* bin = calloc(1, sizeof(Expr));
+        Expr* bin = mem_alloc(p->lexer.A, sizeof(Expr));
         bin->kind = EXPR_BINOP;
         bin->bin.op = op;
         bin->bin.lhs = left;
@@ -71,10 +112,36 @@ Expr* parse_binop(Parser* p) {
     return left;
 }
 
+// arith [cmp arith]: a comparison binds looser than arithmetic and
+// yields 0 or 1 (`a < b < c` is rejected)
+Expr* parse_binop(Parser* p) {
+    Expr* left = parse_arith(p);
+    if (!is_comparison(p->current.type)) return left;
+
+    TokenType op = p->current.type;
+    advance(p);
+    Expr* bin = mem_alloc(p->lexer.A, sizeof(Expr));
+    bin->kind = EXPR_BINOP;
+    bin->bin.op = op;
+    bin->bin.lhs = left;
+    bin->bin.rhs = parse_arith(p);
+    return bin;
+}
+
 // ---------- statements ----------
 
+// { stmt* }
+static Block parse_block(Parser* p) {
+    Block b;
+    expect(p, T_LBRACE, "{");
+    b.stmts = parse_statements(p, &b.count);
+    expect(p, T_RBRACE, "}");
+    return b;
+}
+
 static Stmt* parse_stmt(Parser* p) {
-    Stmt* s = calloc(1, sizeof(Stmt));
+    Stmt* s = mem_alloc(p->lexer.A, sizeof(Stmt));
+    s->line = p->current.line;
 
     if (p->current.type == T_LET) {
         advance(p);
@@ -83,10 +150,10 @@ static Stmt* parse_stmt(Parser* p) {
         expect(p, T_INT_TYPE, "int");
         expect(p, T_EQUAL, "=");
         Expr* value = parse_binop(p);
-        expect(p, T_SEMICOLON, ";");
+        accept_semicolon(p);
 
         s->kind = STMT_LET;
-        s->let_.name = strdup(name.text);
+        s->let_.name = mem_strdup(p->lexer.A, name.text);
         s->let_.init = value;
         return s;
     }
@@ -96,10 +163,10 @@ static Stmt* parse_stmt(Parser* p) {
         Token name = expect(p, T_IDENTIFIER, "variable name");
         expect(p, T_EQUAL, "=");
         Expr* value = parse_binop(p);
-        expect(p, T_SEMICOLON, ";");
+        accept_semicolon(p);
 
         s->kind = STMT_SET;
-        s->set_.name = strdup(name.text);
+        s->set_.name = mem_strdup(p->lexer.A, name.text);
         s->set_.expr = value;
         return s;
     }
@@ -107,13 +174,46 @@ static Stmt* parse_stmt(Parser* p) {
     if (p->current.type == T_RETURN) {
         advance(p);
         Expr* value = parse_binop(p);
-        expect(p, T_SEMICOLON, ";");
+        accept_semicolon(p);
 
         s->kind = STMT_RETURN;
         s->ret_.expr = value;
         return s;
     }
 
+    if (p->current.type == T_IF) {
+        advance(p);
+        s->kind = STMT_IF;
+        s->if_.cond = parse_binop(p);
+        s->if_.then_ = parse_block(p);
+        if (p->current.type == T_ELSE) {
+            advance(p);
+            if (p->current.type == T_IF) {
+                // else if: an else block holding the nested if
+                s->if_.else_.stmts = mem_alloc(p->lexer.A, sizeof(Stmt*));
+                s->if_.else_.stmts[0] = parse_stmt(p);
+                s->if_.else_.count = 1;
+            } else {
+                s->if_.else_ = parse_block(p);
+            }
+        }
+        return s;
+    }
+
+    if (p->current.type == T_WHILE) {
+        advance(p);
+        s->kind = STMT_WHILE;
+        s->while_.cond = parse_binop(p);
+        s->while_.body = parse_block(p);
+        return s;
+    }
+
+    if (p->current.type == T_LBRACE) {
+        s->kind = STMT_BLOCK;
+        s->block_ = parse_block(p);
+        return s;
+    }
+
     fprintf(stderr, "Parse error at line %d: Unexpected token %s\n",
             p->current.line, token_type_to_string(p->current.type));
     exit(1);
@@ -123,7 +223,7 @@ static Stmt* parse_stmt(Parser* p) {
 
 Stmt** parse_statements(Parser* p, int* count) {
     const int CAP = 256;
-    Stmt** stmts = malloc(sizeof(Stmt*) * CAP);
+    Stmt** stmts = mem_alloc(p->lexer.A, sizeof(Stmt*) * CAP);
     int n = 0;
 
     while (p->current.type != T_RBRACE && p->current.type != T_EOF) {
@@ -140,17 +240,53 @@ Stmt** parse_statements(Parser* p, int* count) {
 
 // ---------- function ----------
 
-Function* parse_function(Parser* p) {
+// [export] fn name(a: int, ...) -> int {   (returns the parameter count)
+static int parse_signature(Parser* p, Token* name, bool* exported, Token params[MAX_PARAMS]) {
+    *exported = false;
+    int line = p->current.line;
+    if (p->current.type == T_EXPORT) {
+        advance(p);
+        *exported = true;
+    }
     expect(p, T_FN, "fn");
-    Token name = expect(p, T_IDENTIFIER, "function name");
+    *name = expect(p, T_IDENTIFIER, "function name");
+    name->line = line;  // the header's first line, `export` included
     expect(p, T_LPAREN, "(");
+
+    int n = 0;
+    while (p->current.type != T_RPAREN) {
+        if (n > 0) expect(p, T_COMMA, ",");
+        if (n == MAX_PARAMS) {
+            fprintf(stderr, "Parse error at line %d: more than %d parameters\n",
+                    p->current.line, MAX_PARAMS);
+            exit(1);
+        }
+        params[n++] = expect(p, T_IDENTIFIER, "parameter name");
+        expect(p, T_COLON, ":");
+        expect(p, T_INT_TYPE, "int");
+    }
+
     expect(p, T_RPAREN, ")");
     expect(p, T_ARROW, "->");
     expect(p, T_INT_TYPE, "return type");
     expect(p, T_LBRACE, "{");
+    return n;
+}
 
-    Function* fn = calloc(1, sizeof(Function));
-    fn->name = strdup(name.text);
+Function* parse_function(Parser* p) {
+    Token name;
+    Token params[MAX_PARAMS];
+    bool exported;
+    int nparams = parse_signature(p, &name, &exported, params);
+
+    Function* fn = mem_alloc(p->lexer.A, sizeof(Function));
+    fn->A = p->lexer.A;
+    fn->name = mem_strdup(fn->A, name.text);
+    fn->exported = exported;
+    fn->line = name.line;
+    fn->param_count = nparams;
+    fn->params = mem_alloc(fn->A, sizeof(char*) * MAX_PARAMS);
+    for (int i = 0; i < nparams; i++) fn->params[i] = mem_strdup(fn->A, params[i].text);
 
     fn->stmts = parse_statements(p, &fn->stmt_count);
 
@@ -158,9 +294,102 @@ Function* parse_function(Parser* p) {
     return fn;
 }
 
+// ---------- program ----------
+
+Program* parse_program(Parser* p) {
+    Program* prog = mem_alloc(p->lexer.A, sizeof(Program));
+    prog->A = p->lexer.A;
+    int cap = 8;
+    prog->fns = mem_alloc(prog->A, sizeof(Function*) * cap);
+
+    while (p->current.type != T_EOF) {
+        if (prog->count == cap) {
+            cap *= 2;
+            prog->fns = mem_realloc(prog->A, prog->fns, sizeof(Function*) * cap);
+        }
+        prog->fns[prog->count++] = parse_function(p);
+    }
+    return prog;
+}
+
+// ---------- release ----------
+
+void free_expr(Allocator* A, Expr* e) {
+    if (!e) return;
+    if (e->kind == EXPR_VAR) mem_free(A, e->var_name);
+    if (e->kind == EXPR_BINOP) {
+        free_expr(A, e->bin.lhs);
+        free_expr(A, e->bin.rhs);
+    }
+    if (e->kind == EXPR_CALL) {
+        for (int i = 0; i < e->call.argc; i++) free_expr(A, e->call.args[i]);
+        mem_free(A, e->call.args);
+        mem_free(A, e->call.name);
+    }
+    mem_free(A, e);
+}
+
+void free_stmt(Allocator* A, Stmt* s) {
+    if (!s) return;
+    switch (s->kind) {
+        case STMT_LET:
+            mem_free(A, s->let_.name);
+            free_expr(A, s->let_.init);
+            break;
+        case STMT_SET:
+            mem_free(A, s->set_.name);
+            free_expr(A, s->set_.expr);
+            break;
+        case STMT_RETURN:
+            free_expr(A, s->ret_.expr);
+            break;
+        case STMT_IF:
+            free_expr(A, s->if_.cond);
+            free_block(A, &s->if_.then_);
+            free_block(A, &s->if_.else_);
+            break;
+        case STMT_WHILE:
+            free_expr(A, s->while_.cond);
+            free_block(A, &s->while_.body);
+            break;
+        case STMT_BLOCK:
+            free_block(A, &s->block_);
+            break;
+    }
+    mem_free(A, s);
+}
+
+void free_block(Allocator* A, Block* b) {
+    for (int i = 0; i < b->count; i++) free_stmt(A, b->stmts[i]);
+    mem_free(A, b->stmts);
+    b->stmts = NULL;
+    b->count = 0;
+}
+
+void free_function(Function* fn) {
+    if (!fn) return;
+    for (int i = 0; i < fn->stmt_count; i++) free_stmt(fn->A, fn->stmts[i]);
+    mem_free(fn->A, fn->stmts);
+    for (int i = 0; i < fn->param_count; i++) mem_free(fn->A, fn->params[i]);
+    mem_free(fn->A, fn->params);
+    mem_free(fn->A, fn->name);
+    mem_free(fn->A, fn);
+}
+
+void free_program(Program* prog) {
+    if (!prog) return;
+    for (int i = 0; i < prog->count; i++) free_function(prog->fns[i]);
+    mem_free(prog->A, prog->fns);
+    mem_free(prog->A, prog);
+}
+
 // ---------- init ----------
 
-void init_parser(Parser* p, const char* src) {
-    init_lexer(&p->lexer, src);
+void init_parser(Parser* p, const char* src, Allocator* A) {
+    init_lexer(&p->lexer, src, A);
     advance(p);
+}
+
+void free_parser(Parser* p) {
+    free_lexer(&p->lexer);
 }
\ No newline at end of file
@@ -6,19 +6,27 @@
 typedef enum {
     EXPR_INT,
     EXPR_VAR,
-    EXPR_BINOP
+    EXPR_BINOP,
+    EXPR_CALL
 } ExprKind;
 
 typedef struct Expr {
     ExprKind kind;
+    int su_need;        // codegen: Sethi-Ullman operand-stack slots to evaluate
+    bool su_call;       // codegen: subtree contains a call (keep its order)
     union {
         int int_value;      // e.g., 3
         char* var_name;     // e.g., x
         struct {
-            TokenType op;       // e.g., T_PLUS, T_MINUS, T_STAR, T_SLASH, T_PERCENT
+            TokenType op;       // e.g., T_PLUS, T_MINUS, T_STAR, T_SLASH, T_PERCENT, T_LESS
             struct Expr* lhs;
             struct Expr* rhs;
         } bin;
+        struct {
+            char* name;         // callee, e.g., f in f(1, x)
+            struct Expr** args;
+            int argc;
+        } call;
     };
 } Expr;
 
@@ -27,15 +35,29 @@ typedef struct Expr {
 typedef enum {
     STMT_LET,     // let x: int = expr;
     STMT_SET,     // set x = expr;
-    STMT_RETURN   // return expr;
+    STMT_RETURN,  // return expr;
+    STMT_IF,      // if cond { ... } else { ... }
+    STMT_WHILE,   // while cond { ... }
+    STMT_BLOCK    // { ... }
 } StmtKind;
 
+// A `{ ... }` statement list (if/while bodies, block statements); each
+// one is a scope for the lets inside it
+typedef struct {
+    struct Stmt** stmts;
+    int count;
+} Block;
+
 typedef struct Stmt {
     StmtKind kind;
+    int line;     // source line of the statement's first token
     union {
         struct { char* name; Expr* init; } let_;
         struct { char* name; Expr* expr; } set_;
         struct { Expr* expr; } ret_;
+        struct { Expr* cond; Block then_; Block else_; } if_;  // else_.count may be 0
+        struct { Expr* cond; Block body; } while_;
+        Block block_;
     };
 } Stmt;
 
@@ -43,10 +65,26 @@ typedef struct Stmt {
 
 typedef struct Function {
     char* name;
+    char** params;  // fn name(a: int, b: int): passed in rdi, rsi, ...
+    int param_count;
+    bool exported;  // `export fn`: a root for dead-function elimination
+    int line;       // source line of the `fn` header
     Stmt** stmts;
     int stmt_count;
+    Allocator* A;   // owns every node, name and the stmts array
 } Function;
 
+// SysV integer argument registers available to parameters
+#define MAX_PARAMS 6
+
+// ========== Program ==========
+
+typedef struct Program {
+    Function** fns;
+    int count;
+    Allocator* A;
+} Program;
+
 // ========== Parser ==========
 
 typedef struct {
@@ -56,9 +94,17 @@ typedef struct {
 
 // ========== API ==========
 
-void init_parser(Parser* p, const char* src);
+void init_parser(Parser* p, const char* src, Allocator* A);
+void free_parser(Parser* p);
+Program* parse_program(Parser* p);
 Function* parse_function(Parser* p);
 Stmt** parse_statements(Parser* p, int* count);
 Expr* parse_primary(Parser* p);
 Expr* parse_binop(Parser* p);
-Token expect(Parser* p, TokenType t, const char* what);
\ No newline at end of file
+Token expect(Parser* p, TokenType t, const char* what);
+
+void free_expr(Allocator* A, Expr* e);
+void free_stmt(Allocator* A, Stmt* s);
+void free_block(Allocator* A, Block* b);
+void free_function(Function* fn);
+void free_program(Program* prog);
\ No newline at end of file
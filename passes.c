@@ -0,0 +1,255 @@
+#include "passes.h"
+#include "callgraph.h"
+#include "constprop.h"
+#include "inline.h"
+#include "loopopt.h"
+#include <string.h>
+#include <time.h>
+
+// ----------------------------------------------------------
+// Registered passes
+// ----------------------------------------------------------
+
+typedef struct {
+    const char* name;
+    int level;  // lowest -O level whose preset includes the pass
+    // exactly one of these is set; both return the pass's change count
+    int (*run_program)(Program* prog, bool report);
+    int (*run_ir)(const char* fn, IRList* ir, int* frame_bytes, bool report);
+} Pass;
+
+static int run_inline(Program* prog, bool report) {
+    return inline_program(prog, report ? stdout : NULL);
+}
+
+static int run_constprop(Program* prog, bool report) {
+    (void)report;
+    int removed = 0;
+    for (int i = 0; i < prog->count; i++) removed += constprop_function(prog->fns[i]);
+    return removed;
+}
+
+static int run_dce(Program* prog, bool report) {
+    int dead = eliminate_dead_functions(prog);
+    if (report && dead > 0) printf("dce: removed %d unreachable function(s)\n", dead);
+    return dead;
+}
+
+static int run_loop_opt(const char* fn, IRList* ir, int* frame_bytes, bool report) {
+    LoopOptStats st = loop_optimize(ir, frame_bytes);
+    if (report && st.loops > 0)
+        printf("loops: %s: %d loop(s), %d hoisted, %d strength-reduced\n",
+               fn, st.loops, st.hoisted, st.reduced);
+    if (report && st.skipped > 0)
+        printf("loops: %s: %d loop(s) skipped (irregular shape)\n", fn, st.skipped);
+    return st.hoisted + st.reduced;
+}
+
+// Registry order is the preset order
+static const Pass passes[] = {
+    { "inline",    2, run_inline,    NULL },
+    { "constprop", 1, run_constprop, NULL },
+    { "dce",       1, run_dce,       NULL },
+    { "loop-opt",  2, NULL,          run_loop_opt },
+};
+#define PASS_COUNT (int)(sizeof passes / sizeof passes[0])
+
+static int find_pass(const char* name, size_t len) {
+    for (int i = 0; i < PASS_COUNT; i++) {
+        if (strlen(passes[i].name) == len && strncmp(passes[i].name, name, len) == 0) return i;
+    }
+    fprintf(stderr, "Error: unknown pass '%.*s' (passes: %s)\n", (int)len, name, pm_pass_names());
+    exit(1);
+}
+
+const char* pm_pass_names(void) {
+    static char buf[256];
+    if (!buf[0]) {
+        for (int i = 0; i < PASS_COUNT; i++) {
+            if (i) strcat(buf, ",");
+            strcat(buf, passes[i].name);
+        }
+    }
+    return buf;
+}
+
+// ----------------------------------------------------------
+// Options
+// ----------------------------------------------------------
+
+static void set_level(PassManager* pm, int level) {
+    pm->count = 0;
+    for (int i = 0; i < PASS_COUNT; i++) {
+        if (passes[i].level <= level) pm->pipeline[pm->count++] = i;
+    }
+}
+
+void pm_init(PassManager* pm) {
+    memset(pm, 0, sizeof *pm);
+    set_level(pm, 2);
+    for (int i = 0; i < PASS_COUNT; i++) pm->stats[i].name = passes[i].name;
+    pm->verify.name = "verify";
+}
+
+// Apply f to each name of a comma-separated list
+static void for_each_name(PassManager* pm, const char* list, void (*f)(PassManager*, int)) {
+    while (*list) {
+        const char* end = strchr(list, ',');
+        size_t len = end ? (size_t)(end - list) : strlen(list);
+        if (len > 0) f(pm, find_pass(list, len));
+        list += len;
+        if (*list == ',') list++;
+    }
+}
+
+static void append_pass(PassManager* pm, int index) {
+    if (pm->count == PASS_MAX) {
+        fprintf(stderr, "Error: more than %d passes in -passes=\n", PASS_MAX);
+        exit(1);
+    }
+    pm->pipeline[pm->count++] = index;
+}
+
+static void disable_pass(PassManager* pm, int index) {
+    pm->disabled[index] = true;
+}
+
+bool pm_parse_option(PassManager* pm, const char* arg) {
+    if (strcmp(arg, "-O0") == 0 || strcmp(arg, "-O1") == 0 || strcmp(arg, "-O2") == 0) {
+        set_level(pm, arg[2] - '0');
+    } else if (strncmp(arg, "-passes=", 8) == 0) {
+        pm->count = 0;
+        for_each_name(pm, arg + 8, append_pass);
+    } else if (strncmp(arg, "-disable-pass=", 14) == 0) {
+        for_each_name(pm, arg + 14, disable_pass);
+    } else if (strcmp(arg, "--time-passes") == 0) {
+        pm->time_passes = true;
+    } else if (strcmp(arg, "--no-inline") == 0) {
+        for_each_name(pm, "inline", disable_pass);
+    } else if (strcmp(arg, "--no-constprop") == 0) {
+        for_each_name(pm, "constprop", disable_pass);
+    } else if (strcmp(arg, "--no-loop-opt") == 0) {
+        for_each_name(pm, "loop-opt", disable_pass);
+    } else if (strcmp(arg, "--inline-report") == 0) {
+        pm->report[find_pass("inline", 6)] = true;
+    } else if (strcmp(arg, "--loop-report") == 0) {
+        pm->report[find_pass("loop-opt", 8)] = true;
+    } else if (strcmp(arg, "--dce-report") == 0) {
+        pm->report[find_pass("dce", 3)] = true;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------
+// Running
+// ----------------------------------------------------------
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static long expr_nodes(const Expr* e) {
+    if (!e) return 0;
+    if (e->kind == EXPR_BINOP) return 1 + expr_nodes(e->bin.lhs) + expr_nodes(e->bin.rhs);
+    if (e->kind == EXPR_CALL) {
+        long n = 1;
+        for (int i = 0; i < e->call.argc; i++) n += expr_nodes(e->call.args[i]);
+        return n;
+    }
+    return 1;
+}
+
+static long block_nodes(Stmt** stmts, int count);
+
+static long stmt_nodes(const Stmt* s) {
+    switch (s->kind) {
+        case STMT_LET:    return 1 + expr_nodes(s->let_.init);
+        case STMT_SET:    return 1 + expr_nodes(s->set_.expr);
+        case STMT_RETURN: return 1 + expr_nodes(s->ret_.expr);
+        case STMT_IF:
+            return 1 + expr_nodes(s->if_.cond) + block_nodes(s->if_.then_.stmts, s->if_.then_.count) +
+                   block_nodes(s->if_.else_.stmts, s->if_.else_.count);
+        case STMT_WHILE:
+            return 1 + expr_nodes(s->while_.cond) + block_nodes(s->while_.body.stmts, s->while_.body.count);
+        case STMT_BLOCK:
+            return 1 + block_nodes(s->block_.stmts, s->block_.count);
+    }
+    return 1;
+}
+
+static long block_nodes(Stmt** stmts, int count) {
+    long n = 0;
+    for (int i = 0; i < count; i++) n += stmt_nodes(stmts[i]);
+    return n;
+}
+
+// AST size of the module: statements plus expression nodes
+static long program_nodes(const Program* prog) {
+    long n = 0;
+    for (int i = 0; i < prog->count; i++) n += 1 + block_nodes(prog->fns[i]->stmts, prog->fns[i]->stmt_count);
+    return n;
+}
+
+void pm_run_program(PassManager* pm, Program* prog) {
+    for (int i = 0; i < pm->count; i++) {
+        int index = pm->pipeline[i];
+        if (pm->disabled[index] || !passes[index].run_program) continue;
+        PassStats* st = &pm->stats[index];
+        st->size_before += program_nodes(prog);
+        double t0 = now_seconds();
+        st->changes += passes[index].run_program(prog, pm->report[index]);
+        st->seconds += now_seconds() - t0;
+        st->size_after += program_nodes(prog);
+        st->runs++;
+    }
+}
+
+static void verify(PassManager* pm, const char* fn, const IRList* ir, int frame_bytes,
+                   const char* after) {
+    char msg[160];
+    double t0 = now_seconds();
+    bool ok = ir_verify(ir, frame_bytes, msg, sizeof msg);
+    pm->verify.seconds += now_seconds() - t0;
+    pm->verify.size_before += ir->count;
+    pm->verify.size_after += ir->count;
+    pm->verify.runs++;
+    if (!ok) {
+        fprintf(stderr, "Error: invalid IR in %s after %s: %s\n", fn, after, msg);
+        exit(1);
+    }
+}
+
+void pm_run_ir(PassManager* pm, const char* fn, IRList* ir, int* frame_bytes) {
+    verify(pm, fn, ir, *frame_bytes, "codegen");
+    for (int i = 0; i < pm->count; i++) {
+        int index = pm->pipeline[i];
+        if (pm->disabled[index] || !passes[index].run_ir) continue;
+        PassStats* st = &pm->stats[index];
+        st->size_before += ir->count;
+        double t0 = now_seconds();
+        st->changes += passes[index].run_ir(fn, ir, frame_bytes, pm->report[index]);
+        st->seconds += now_seconds() - t0;
+        st->size_after += ir->count;
+        st->runs++;
+        verify(pm, fn, ir, *frame_bytes, passes[index].name);
+    }
+}
+
+static void print_row(FILE* out, const PassStats* st, const char* unit) {
+    if (st->runs == 0) return;
+    fprintf(out, "%-10s %5d %10.3f %6s %8ld %8ld %8ld\n", st->name, st->runs, st->seconds * 1e3,
+            unit, st->size_before, st->size_after, st->changes);
+}
+
+void pm_print_stats(const PassManager* pm, FILE* out) {
+    if (!pm->time_passes) return;
+    fprintf(out, "%-10s %5s %10s %6s %8s %8s %8s\n", "pass", "runs", "time(ms)", "unit",
+            "before", "after", "changes");
+    for (int i = 0; i < PASS_COUNT; i++)
+        print_row(out, &pm->stats[i], passes[i].run_program ? "ast" : "ir");
+    print_row(out, &pm->verify, "ir");
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <stdio.h>
+#include "parser.h"
+#include "stack_machine_ir.h"
+
+// ==========================================================
+// Pass manager
+//
+// Optimizations are registered passes of two kinds: program passes
+// rewrite the AST of the whole module before codegen, IR passes rewrite
+// one function's IRList after it. A pipeline is an ordered list of pass
+// names; program passes run in their pipeline order, then codegen, then
+// IR passes in theirs.
+//
+// Presets: -O0 runs nothing, -O1 the cheap AST cleanups, -O2 (the
+// default) everything. -passes=a,b,... replaces the pipeline and
+// -disable-pass=a,... drops passes from whatever pipeline is chosen.
+//
+// The IR verifier (ir_verify) runs on codegen output and after every IR
+// pass; a pass that breaks the IR is named in the error. With
+// --time-passes each pass reports wall time and code size before and
+// after (AST nodes for program passes, IR instructions for IR passes).
+// ==========================================================
+
+#define PASS_MAX 16
+
+typedef struct {
+    const char* name;
+    int runs;           // program passes: 1, IR passes: functions visited
+    double seconds;
+    long size_before;
+    long size_after;
+    long changes;       // pass-specific count (inlined calls, hoisted expressions, ...)
+} PassStats;
+
+typedef struct {
+    int pipeline[PASS_MAX];  // registry indices, in run order
+    int count;
+    bool disabled[PASS_MAX];
+    bool report[PASS_MAX];   // --inline-report, --loop-report, --dce-report
+    bool time_passes;
+    PassStats stats[PASS_MAX];
+    PassStats verify;        // ir_verify calls, reported like a pass
+} PassManager;
+
+// Start from the -O2 pipeline.
+void pm_init(PassManager* pm);
+
+// Handle one command-line option if it belongs to the pass manager:
+// -O0/-O1/-O2, -passes=, -disable-pass=, --time-passes, the older
+// --no-inline/--no-constprop/--no-loop-opt spellings and the per-pass
+// --inline-report/--loop-report/--dce-report. Unknown pass names are fatal.
+bool pm_parse_option(PassManager* pm, const char* arg);
+
+// Comma-separated names of the registered passes, for usage messages.
+const char* pm_pass_names(void);
+
+// Run the enabled program passes over the AST.
+void pm_run_program(PassManager* pm, Program* prog);
+
+// Verify fn's IR, then run each enabled IR pass on it and verify again.
+void pm_run_ir(PassManager* pm, const char* fn, IRList* ir, int* frame_bytes);
+
+// --time-passes table (no-op otherwise).
+void pm_print_stats(const PassManager* pm, FILE* out);
@@ -0,0 +1,160 @@
+#include "regalloc.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Callee-saved under SysV, so values survive calls without extra saves
+static const char* const reg_names[REGALLOC_NUM_REGS] = { "rbx", "r12", "r13", "r14", "r15" };
+
+const char* regalloc_reg_name(int reg) {
+    return (reg >= 0 && reg < REGALLOC_NUM_REGS) ? reg_names[reg] : NULL;
+}
+
+// ----------------------------------------------------------
+// Live intervals
+// ----------------------------------------------------------
+
+static int slot_of(int offset) {
+    return offset / 8 - 1;
+}
+
+static int cmp_start(const void* a, const void* b) {
+    const LiveInterval* x = a;
+    const LiveInterval* y = b;
+    return x->start - y->start;
+}
+
+// A slot accessed anywhere inside a loop [head, back edge] is live for
+// the whole loop: its value may flow around the back edge. Widening one
+// interval can pull it into an enclosing loop, so repeat to a fixed point.
+static void extend_over_loops(const IRList* ir, RegAllocation* ra) {
+    int labels = 0;
+    for (int i = 0; i < ir->count; i++) {
+        if (ir->code[i].op == IR_LABEL && ir->code[i].imm >= labels) labels = ir->code[i].imm + 1;
+    }
+    if (labels == 0) return;
+    int* label_at = mem_alloc(ra->A, sizeof(int) * labels);
+    for (int i = 0; i < ir->count; i++) {
+        if (ir->code[i].op == IR_LABEL) label_at[ir->code[i].imm] = i;
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int j = 0; j < ir->count; j++) {
+            if (ir->code[j].op != IR_JMP && ir->code[j].op != IR_JZ) continue;
+            int head = label_at[ir->code[j].imm];
+            if (head > j) continue;  // forward jump
+            for (int k = 0; k < ra->count; k++) {
+                LiveInterval* iv = &ra->intervals[k];
+                if (iv->end < head || iv->start > j) continue;
+                if (iv->start > head) { iv->start = head; changed = true; }
+                if (iv->end < j) { iv->end = j; changed = true; }
+            }
+        }
+    }
+    mem_free(ra->A, label_at);
+}
+
+// Straight-line code keeps a slot live from its first to its last
+// access (a read before any write sees an undefined value either way);
+// loops then widen that range.
+static void build_intervals(const IRList* ir, RegAllocation* ra) {
+    for (int i = 0; i < ir->count; i++) {
+        if (ir->code[i].op != IR_LOAD && ir->code[i].op != IR_STORE) continue;
+        int s = slot_of(ir->code[i].imm);
+        if (s >= ra->slot_count) ra->slot_count = s + 1;
+    }
+
+    int* index = mem_alloc(ra->A, sizeof(int) * (ra->slot_count + 1));
+    for (int s = 0; s < ra->slot_count; s++) index[s] = -1;
+    ra->intervals = mem_alloc(ra->A, sizeof(LiveInterval) * (ra->slot_count + 1));
+
+    for (int i = 0; i < ir->count; i++) {
+        if (ir->code[i].op != IR_LOAD && ir->code[i].op != IR_STORE) continue;
+        int s = slot_of(ir->code[i].imm);
+        if (index[s] < 0) {
+            index[s] = ra->count;
+            ra->intervals[ra->count++] = (LiveInterval){ ir->code[i].imm, i, i, -1 };
+        }
+        ra->intervals[index[s]].end = i;
+    }
+    mem_free(ra->A, index);
+    extend_over_loops(ir, ra);
+
+    // Widening can reorder starts, so sort
+    qsort(ra->intervals, ra->count, sizeof(LiveInterval), cmp_start);
+}
+
+// ----------------------------------------------------------
+// Linear scan (Poletto & Sarkar)
+// ----------------------------------------------------------
+
+void regalloc_linear_scan(const IRList* ir, RegAllocation* ra) {
+    memset(ra, 0, sizeof *ra);
+    ra->A = ir->A;
+    build_intervals(ir, ra);
+
+    LiveInterval* active[REGALLOC_NUM_REGS];  // sorted by increasing end
+    int nactive = 0;
+    bool reg_free[REGALLOC_NUM_REGS];
+    for (int r = 0; r < REGALLOC_NUM_REGS; r++) reg_free[r] = true;
+
+    for (int i = 0; i < ra->count; i++) {
+        LiveInterval* cur = &ra->intervals[i];
+
+        // Expire intervals that ended before this one starts
+        int keep = 0;
+        for (int k = 0; k < nactive; k++) {
+            if (active[k]->end < cur->start) reg_free[active[k]->reg] = true;
+            else active[keep++] = active[k];
+        }
+        nactive = keep;
+
+        if (nactive == REGALLOC_NUM_REGS) {
+            // Spill whichever interval reaches furthest
+            LiveInterval* last = active[nactive - 1];
+            if (last->end <= cur->end) {
+                ra->spilled++;
+                continue;
+            }
+            cur->reg = last->reg;
+            last->reg = -1;
+            ra->spilled++;
+            nactive--;
+        } else {
+            for (int r = 0; r < REGALLOC_NUM_REGS; r++) {
+                if (reg_free[r]) {
+                    cur->reg = r;
+                    reg_free[r] = false;
+                    break;
+                }
+            }
+        }
+
+        int k = nactive++;
+        while (k > 0 && active[k - 1]->end > cur->end) {
+            active[k] = active[k - 1];
+            k--;
+        }
+        active[k] = cur;
+    }
+
+    ra->slot_reg = mem_alloc(ra->A, sizeof(int) * (ra->slot_count + 1));
+    for (int s = 0; s < ra->slot_count; s++) ra->slot_reg[s] = -1;
+    for (int i = 0; i < ra->count; i++) {
+        LiveInterval* iv = &ra->intervals[i];
+        ra->slot_reg[slot_of(iv->offset)] = iv->reg;
+        if (iv->reg >= 0) ra->used_regs |= 1u << iv->reg;
+    }
+}
+
+int regalloc_reg_of(const RegAllocation* ra, int offset) {
+    int s = slot_of(offset);
+    return (s >= 0 && s < ra->slot_count) ? ra->slot_reg[s] : -1;
+}
+
+void regalloc_free(RegAllocation* ra) {
+    mem_free(ra->A, ra->intervals);
+    mem_free(ra->A, ra->slot_reg);
+    memset(ra, 0, sizeof *ra);
+}
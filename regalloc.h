@@ -0,0 +1,35 @@
+#pragma once
+#include "stack_machine_ir.h"
+
+// Linear-scan register allocation for frame slots (--regalloc).
+// Locals are the 8-byte slots [rbp-offset] touched by IR_LOAD/IR_STORE.
+// Each gets a live interval from its first to its last access, widened
+// to cover any loop (label .. backward jump) it is accessed in; intervals
+// are assigned to the callee-saved registers rbx, r12-r15 in order of
+// start, and when all are busy the interval ending last is spilled and
+// keeps its existing frame slot.
+#define REGALLOC_NUM_REGS 5
+
+typedef struct {
+    int offset;  // frame slot [rbp-offset]
+    int start;   // first IR index accessing the slot
+    int end;     // last IR index accessing the slot
+    int reg;     // register index, or -1 if spilled
+} LiveInterval;
+
+typedef struct {
+    LiveInterval* intervals;  // sorted by start
+    int count;
+    int* slot_reg;            // per slot (offset/8 - 1): register index or -1
+    int slot_count;
+    unsigned used_regs;       // bit i set: register i is assigned (must be saved)
+    int spilled;              // intervals left in memory
+    Allocator* A;             // the IRList's; owns intervals and slot_reg
+} RegAllocation;
+
+void regalloc_linear_scan(const IRList* ir, RegAllocation* ra);
+void regalloc_free(RegAllocation* ra);
+
+// Register holding the slot at [rbp-offset], or -1 if it stays in memory.
+int regalloc_reg_of(const RegAllocation* ra, int offset);
+const char* regalloc_reg_name(int reg);
@@ -1,68 +1,468 @@
 #include "stack_machine_ir.h"
+#include "regalloc.h"
+#include <stdarg.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// SysV AMD64 integer argument registers, in order
+static const char* const arg_regs[] = { "rdi", "rsi", "rdx", "rcx", "r8", "r9" };
+
+// Module function names: IR_CALL's immediate indexes this list
+static const char* const* g_callees = NULL;
+static int g_callee_count = 0;
+
+void stack_machine_set_callees(const char* const* names, int count) {
+    g_callees = names;
+    g_callee_count = count;
+}
+
+// ----------------------------------------------------------
+// Instrumentation: one 64-bit counter per IR_LINE
+// ----------------------------------------------------------
+// Counter i lives at jive_prof_counters+8*i; its source line and kind
+// (function entry or statement) are recorded here and written out by
+// stack_machine_emit_profile_data.
+
+typedef struct {
+    int line;
+    bool entry;
+} ProfSite;
+
+static bool g_instrument = false;
+static Allocator* g_site_alloc = NULL;  // the emitted IRLists' allocator
+static ProfSite* g_sites = NULL;
+static int g_site_count = 0;
+static int g_site_cap = 0;
+
+void stack_machine_set_instrument(bool on) {
+    g_instrument = on;
+}
+
+static int prof_site(Allocator* A, int line, bool entry) {
+    if (g_site_count == g_site_cap) {
+        if (!g_sites) g_site_alloc = A;
+        g_site_cap = (g_site_cap == 0) ? 64 : g_site_cap * 2;
+        g_sites = mem_realloc(g_site_alloc, g_sites, sizeof(ProfSite) * g_site_cap);
+    }
+    g_sites[g_site_count] = (ProfSite){ line, entry };
+    return g_site_count++;
+}
+
+void stack_machine_emit_profile_data(FILE* out, const char* source_path) {
+    fprintf(out, "\nsection .data\n");
+    fprintf(out, "global jive_prof_count\nglobal jive_prof_counters\n");
+    fprintf(out, "global jive_prof_lines\nglobal jive_prof_source\n");
+    fprintf(out, "align 8\n");
+    fprintf(out, "jive_prof_count: dq %d\n", g_site_count);
+    fprintf(out, "jive_prof_counters: times %d dq 0\n", g_site_count);
+
+    // Line table: positive for statements, negative for function entries
+    fprintf(out, "jive_prof_lines:");
+    for (int i = 0; i < g_site_count; i++) {
+        fprintf(out, "%s %d", (i % 16) ? "," : (i ? "\n    dd" : " dd"),
+                g_sites[i].entry ? -g_sites[i].line : g_sites[i].line);
+    }
+    if (g_site_count == 0) fprintf(out, " dd 0");
+    fprintf(out, "\n");
+
+    fprintf(out, "jive_prof_source: db ");
+    for (const char* c = source_path; *c; c++) fprintf(out, "%d, ", (unsigned char)*c);
+    fprintf(out, "0\n");
+
+    mem_free(g_site_alloc, g_sites);
+    g_sites = NULL;
+    g_site_count = g_site_cap = 0;
+}
+
+// ----------------------------------------------------------
+// Register allocation (--regalloc)
+// ----------------------------------------------------------
+
+static bool g_regalloc = false;
+
+void stack_machine_set_regalloc(bool on) {
+    g_regalloc = on;
+}
+
+// ----------------------------------------------------------
+// Size model
+// ----------------------------------------------------------
+// Every instruction goes through insn() with its encoded length, so the
+// total is known without assembling. Lengths are those NASM picks for
+// the form as written (mov r64, imm with a non-negative 32-bit imm is
+// mov r32, imm32); jumps are counted as rel32 (NASM may relax them to 2
+// bytes).
+
+static long g_code_bytes = 0;
+
+long stack_machine_code_bytes(void) {
+    return g_code_bytes;
+}
+
+static void insn(FILE* out, int bytes, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(out, "    ");
+    vfprintf(out, fmt, ap);
+    fprintf(out, "\n");
+    va_end(ap);
+    g_code_bytes += bytes;
+}
+
+// r8-r15 and their 32-bit halves need a REX prefix
+static int rex(const char* reg) {
+    return reg[0] == 'r' && reg[1] >= '0' && reg[1] <= '9';
+}
+
+static bool fits_imm8(long v) {
+    return v >= -128 && v <= 127;
+}
+
+// ModRM + displacement of [rbp-offset]
+static int rbp_operand(int offset) {
+    return fits_imm8(-offset) ? 2 : 5;
+}
+
+static void push_reg(FILE* out, const char* reg) {
+    insn(out, 1 + rex(reg), "push %s", reg);
+}
+
+static void pop_reg(FILE* out, const char* reg) {
+    insn(out, 1 + rex(reg), "pop %s", reg);
+}
+
+// 32-bit name of a 64-bit register, for the zero-extending forms
+static const char* reg32(const char* reg) {
+    static const struct { const char* r64; const char* r32; } names[] = {
+        { "rax", "eax" }, { "rbx", "ebx" }, { "rcx", "ecx" }, { "rdx", "edx" },
+        { "rsi", "esi" }, { "rdi", "edi" }, { "r8", "r8d" }, { "r9", "r9d" },
+        { "r12", "r12d" }, { "r13", "r13d" }, { "r14", "r14d" }, { "r15", "r15d" },
+    };
+    for (int i = 0; i < (int)(sizeof names / sizeof names[0]); i++) {
+        if (strcmp(names[i].r64, reg) == 0) return names[i].r32;
+    }
+    return reg;
+}
+
+// ----------------------------------------------------------
+// Size-optimized emission (-Os)
+// ----------------------------------------------------------
+
+static bool g_size_opt = false;
+
+void stack_machine_set_size_opt(bool on) {
+    g_size_opt = on;
+}
+
+// reg = v in the fewest bytes. 32-bit writes zero-extend, so mov r32 is
+// only right for v >= 0; a negative v goes through the sign-extending push.
+static void load_imm(FILE* out, const char* reg, int v) {
+    int push_pop = (fits_imm8(v) ? 2 : 5) + 1 + rex(reg);
+    if (v == 0) {
+        insn(out, 2 + rex(reg), "xor %s, %s", reg32(reg), reg32(reg));
+    } else if (v > 0 && 5 + rex(reg) < push_pop) {
+        insn(out, 5 + rex(reg), "mov %s, %d", reg32(reg), v);
+    } else {
+        insn(out, fits_imm8(v) ? 2 : 5, "push %d", v);
+        pop_reg(out, reg);
+    }
+}
+
+// Frame slots ordered by access count, so the hottest get disp8
+// addressing: slot_map[offset / 8] is the slot's new offset
+static int* hot_slot_map(const IRList* ir, const RegAllocation* ra, int local_bytes) {
+    int n = local_bytes / 8;
+    int* count = mem_alloc(ir->A, sizeof(int) * (n + 1));
+    int* order = mem_alloc(ir->A, sizeof(int) * (n + 1));
+    int* map = mem_alloc(ir->A, sizeof(int) * (n + 1));
+    for (int i = 0; i < ir->count; i++) {
+        IR in = ir->code[i];
+        if (in.op != IR_LOAD && in.op != IR_STORE) continue;
+        if (g_regalloc && regalloc_reg_of(ra, in.imm) >= 0) continue;  // never addressed
+        if (in.imm / 8 <= n) count[in.imm / 8]++;
+    }
+    // stable insertion sort of slots 1..n by decreasing count
+    for (int k = 1; k <= n; k++) {
+        int j = k - 1;
+        while (j > 0 && count[order[j - 1]] < count[k]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = k;
+    }
+    map[0] = 0;
+    for (int k = 0; k < n; k++) map[order[k]] = 8 * (k + 1);
+    mem_free(ir->A, count);
+    mem_free(ir->A, order);
+    return map;
+}
+
+// ----------------------------------------------------------
+// Emission
+// ----------------------------------------------------------
+
+// Callee-saved registers in use are saved in frame slots just below the
+// locals, so rsp stays 16-byte aligned and the depth rule below holds.
+static void emit_saves(FILE* out, const RegAllocation* ra, int local_bytes_aligned, bool restore) {
+    int offset = local_bytes_aligned;
+    for (int r = 0; r < REGALLOC_NUM_REGS; r++) {
+        if (!(ra->used_regs & (1u << r))) continue;
+        offset += 8;
+        int bytes = 2 + rbp_operand(offset);
+        if (restore) insn(out, bytes, "mov %s, [rbp-%d]", regalloc_reg_name(r), offset);
+        else insn(out, bytes, "mov [rbp-%d], %s", offset, regalloc_reg_name(r));
+    }
+}
+
+// rax holds the return value: jump to the epilogue unless this is the end
+static void emit_return(FILE* out, const IRList* ir, int i, bool* exit_used) {
+    if (i + 1 < ir->count) {
+        insn(out, 5, "jmp .exit");
+        *exit_used = true;
+    }
+}
 
 void stack_machine_emit(FILE* out, const char* fn_name, IRList* ir, int local_bytes_aligned) {
+    RegAllocation ra = {0};
+    if (g_regalloc) regalloc_linear_scan(ir, &ra);
+    int saved = __builtin_popcount(ra.used_regs);
+    int frame = local_bytes_aligned + ((8 * saved + 15) & ~15);
+    int* slot_map = g_size_opt ? hot_slot_map(ir, &ra, local_bytes_aligned) : NULL;
+
     // ---- Function prologue ----
     fprintf(out, "global %s\n%s:\n", fn_name, fn_name);
-    fprintf(out, "    push rbp\n");
-    fprintf(out, "    mov rbp, rsp\n");
-    if (local_bytes_aligned > 0)
-        fprintf(out, "    sub rsp, %d\n", local_bytes_aligned);
+    insn(out, 1, "push rbp");
+    insn(out, 3, "mov rbp, rsp");
+    if (frame > 0)
+        insn(out, fits_imm8(frame) ? 4 : 7, "sub rsp, %d", frame);
+    emit_saves(out, &ra, local_bytes_aligned, false);
+
+    // Operand-stack depth in 8-byte slots. rsp is 16-byte aligned after
+    // the prologue, so it stays aligned at a call iff the depth is even.
+    int depth = 0;
+    bool entry = true;  // codegen emits the function's own IR_LINE first
+    bool exit_used = false;
 
     // ---- Translate each IR instruction ----
+    // rcx is the scratch register: rbx is callee-saved under SysV.
     for (int i = 0; i < ir->count; i++) {
         IR instr = ir->code[i];
+        IR next = (i + 1 < ir->count) ? ir->code[i + 1] : (IR){ IR_LINE, 0 };
+        int reg = -1;  // register of a LOAD/STORE slot under --regalloc
+        int offset = instr.imm;
+        if (instr.op == IR_LOAD || instr.op == IR_STORE) {
+            if (g_regalloc) reg = regalloc_reg_of(&ra, instr.imm);
+            if (slot_map && instr.imm / 8 <= local_bytes_aligned / 8) offset = slot_map[instr.imm / 8];
+        }
+
         switch (instr.op) {
-            case IR_PUSH_INT:
-                fprintf(out, "    mov rax, %d\n", instr.imm);
-                fprintf(out, "    push rax\n");
-                break;
+            case IR_PUSH_INT: {
+                if (!g_size_opt) {
+                    // NASM encodes a non-negative one as mov eax, imm32
+                    insn(out, instr.imm >= 0 ? 5 : 7, "mov rax, %d", instr.imm);
+                    insn(out, 1, "push rax");
+                    break;
+                }
+                // -Os: fold the constant into its consumer where that is shorter
+                int imm_bytes = fits_imm8(instr.imm) ? 1 : 4;
+                int store_reg = (g_regalloc && next.op == IR_STORE) ? regalloc_reg_of(&ra, next.imm) : -1;
+                if (next.op == IR_ADD || next.op == IR_SUB) {
+                    insn(out, 4 + imm_bytes, "%s qword [rsp], %d", next.op == IR_ADD ? "add" : "sub", instr.imm);
+                } else if (next.op == IR_MUL) {
+                    pop_reg(out, "rax");
+                    insn(out, 3 + imm_bytes, "imul rax, rax, %d", instr.imm);
+                    push_reg(out, "rax");
+                } else if (next.op == IR_RET) {
+                    load_imm(out, "rax", instr.imm);
+                    emit_return(out, ir, i + 1, &exit_used);
+                } else if (next.op == IR_ARG) {
+                    load_imm(out, arg_regs[next.imm], instr.imm);
+                } else if (store_reg >= 0) {
+                    load_imm(out, regalloc_reg_name(store_reg), instr.imm);
+                } else {
+                    insn(out, 1 + imm_bytes, "push %d", instr.imm);
+                    break;
+                }
+                i++;  // consumed next; PUSH + consumer leaves the depth unchanged
+                continue;
+            }
 
             case IR_ADD:
-                fprintf(out, "    pop rbx\n    pop rax\n");
-                fprintf(out, "    add rax, rbx\n    push rax\n");
-                break;
-
             case IR_SUB:
-                fprintf(out, "    pop rbx\n    pop rax\n");
-                fprintf(out, "    sub rax, rbx\n    push rax\n");
+                if (g_size_opt) {
+                    // pop the right operand into rcx and combine in place.
+                    // Only add/sub gain from this: imul, cmp + setcc and
+                    // the reversed ops cannot write [rsp] in fewer bytes
+                    // than the pop/op/push form below
+                    pop_reg(out, "rcx");
+                    insn(out, 4, "%s [rsp], rcx", instr.op == IR_ADD ? "add" : "sub");
+                    break;
+                }
+                pop_reg(out, "rcx");
+                pop_reg(out, "rax");
+                insn(out, 3, "%s rax, rcx", instr.op == IR_ADD ? "add" : "sub");
+                push_reg(out, "rax");
                 break;
 
             case IR_MUL:
-                fprintf(out, "    pop rbx\n    pop rax\n");
-                fprintf(out, "    imul rax, rbx\n    push rax\n");
+                pop_reg(out, "rcx");
+                pop_reg(out, "rax");
+                insn(out, 4, "imul rax, rcx");
+                push_reg(out, "rax");
                 break;
 
             case IR_DIV:
-                fprintf(out, "    pop rbx\n    pop rax\n");
-                fprintf(out, "    cqo\n    idiv rbx\n    push rax\n");
+            case IR_MOD:
+                pop_reg(out, "rcx");
+                pop_reg(out, "rax");
+                insn(out, 2, "cqo");
+                insn(out, 3, "idiv rcx");
+                push_reg(out, instr.op == IR_DIV ? "rax" : "rdx");
                 break;
 
-            case IR_MOD:
-                fprintf(out, "    pop rbx\n    pop rax\n");
-                fprintf(out, "    cqo\n    idiv rbx\n    push rdx\n");
+            // ---- Reversed operands: the left operand is on top ----
+            case IR_SUB_R:
+                pop_reg(out, "rax");
+                pop_reg(out, "rcx");
+                insn(out, 3, "sub rax, rcx");
+                push_reg(out, "rax");
+                break;
+
+            case IR_DIV_R:
+            case IR_MOD_R:
+                pop_reg(out, "rax");
+                pop_reg(out, "rcx");
+                insn(out, 2, "cqo");
+                insn(out, 3, "idiv rcx");
+                push_reg(out, instr.op == IR_DIV_R ? "rax" : "rdx");
                 break;
 
             // ---- NEW: local variable support ----
             case IR_LOAD:
-                // load value from [rbp - offset] and push
-                fprintf(out, "    mov rax, [rbp-%d]\n", instr.imm);
-                fprintf(out, "    push rax\n");
+                // load value from [rbp - offset] (or its register) and push
+                if (reg >= 0) {
+                    push_reg(out, regalloc_reg_name(reg));
+                } else if (g_size_opt) {
+                    insn(out, 1 + rbp_operand(offset), "push qword [rbp-%d]", offset);
+                } else {
+                    insn(out, 2 + rbp_operand(offset), "mov rax, [rbp-%d]", offset);
+                    push_reg(out, "rax");
+                }
                 break;
 
             case IR_STORE:
-                // pop value and store into [rbp - offset]
-                fprintf(out, "    pop rax\n");
-                fprintf(out, "    mov [rbp-%d], rax\n", instr.imm);
+                // pop value and store into [rbp - offset] (or its register)
+                if (reg >= 0) {
+                    pop_reg(out, regalloc_reg_name(reg));
+                } else if (g_size_opt) {
+                    insn(out, 1 + rbp_operand(offset), "pop qword [rbp-%d]", offset);
+                } else {
+                    pop_reg(out, "rax");
+                    insn(out, 2 + rbp_operand(offset), "mov [rbp-%d], rax", offset);
+                }
                 break;
 
             case IR_RET:
-                fprintf(out, "    pop rax\n");
+                pop_reg(out, "rax");
+                emit_return(out, ir, i, &exit_used);
+                break;
+
+            // ---- Comparisons: 0/1 in rax ----
+            case IR_LT:
+            case IR_LE:
+            case IR_GT:
+            case IR_GE:
+            case IR_EQ:
+            case IR_NE: {
+                static const char* const setcc[] = { "setl", "setle", "setg", "setge", "sete", "setne" };
+                const char* cc = setcc[instr.op - IR_LT];
+                if (g_size_opt) {
+                    // clear rax up front instead of movzx after setcc
+                    pop_reg(out, "rcx");
+                    pop_reg(out, "rdx");
+                    insn(out, 2, "xor eax, eax");
+                    insn(out, 3, "cmp rdx, rcx");
+                    insn(out, 3, "%s al", cc);
+                    push_reg(out, "rax");
+                    break;
+                }
+                pop_reg(out, "rcx");
+                pop_reg(out, "rax");
+                insn(out, 3, "cmp rax, rcx");
+                insn(out, 3, "%s al", cc);
+                insn(out, 3, "movzx eax, al");
+                push_reg(out, "rax");
+                break;
+            }
+
+            // ---- Control flow (labels are local to the function) ----
+            case IR_LABEL:
+                fprintf(out, ".L%d:\n", instr.imm);
+                break;
+
+            case IR_JMP:
+                insn(out, 5, "jmp .L%d", instr.imm);
+                break;
+
+            case IR_JZ:
+                pop_reg(out, "rax");
+                insn(out, 3, "test rax, rax");
+                insn(out, 6, "jz .L%d", instr.imm);
+                break;
+
+            // ---- Calls (SysV AMD64) ----
+            case IR_PARAM: {
+                // PARAM i; STORE off -> one move when the slot has a register
+                int r = (g_regalloc && next.op == IR_STORE) ? regalloc_reg_of(&ra, next.imm) : -1;
+                if (r >= 0) {
+                    insn(out, 3, "mov %s, %s", regalloc_reg_name(r), arg_regs[instr.imm]);
+                    i++;
+                    continue;
+                }
+                push_reg(out, arg_regs[instr.imm]);
+                break;
+            }
+
+            case IR_ARG:
+                pop_reg(out, arg_regs[instr.imm]);
+                break;
+
+            case IR_CALL: {
+                const char* callee = (instr.imm >= 0 && instr.imm < g_callee_count)
+                                   ? g_callees[instr.imm] : NULL;
+                if (!callee) {
+                    fprintf(stderr, "Error: %s: call to unknown function #%d\n", fn_name, instr.imm);
+                    exit(1);
+                }
+                if (depth % 2) insn(out, 4, "sub rsp, 8");
+                insn(out, 5, "call %s", callee);
+                if (depth % 2) insn(out, 4, "add rsp, 8");
+                push_reg(out, "rax");
+                break;
+            }
+
+            // ---- Profiling ----
+            case IR_LINE:
+                if (g_instrument) {
+                    int k = prof_site(ir->A, instr.imm, entry);
+                    insn(out, 7, "inc qword [rel jive_prof_counters+%d]", 8 * k);
+                }
+                entry = false;
+                break;
+
+            default:
                 break;
         }
+        depth += ir_stack_effect(instr.op);
     }
 
     // ---- Function epilogue ----
-    fprintf(out, "    leave\n");
-    fprintf(out, "    ret\n");
-}
\ No newline at end of file
+    if (exit_used) fprintf(out, ".exit:\n");
+    emit_saves(out, &ra, local_bytes_aligned, true);
+    regalloc_free(&ra);
+    mem_free(ir->A, slot_map);
+    insn(out, 1, "leave");
+    insn(out, 1, "ret");
+}
@@ -1,6 +1,34 @@
 #pragma once
+#include <stdbool.h>
 #include <stdio.h>
 #include "stack_machine_ir.h"
 
 // Emits x86-64 assembly from the intermediate representation (IR).
-void stack_machine_emit(FILE* out, const char* fn_name, IRList* ir, int locals);
\ No newline at end of file
+void stack_machine_emit(FILE* out, const char* fn_name, IRList* ir, int locals);
+
+// Names of the module's functions, indexed by IR_CALL's immediate.
+// The arrays must stay alive until emission is done.
+void stack_machine_set_callees(const char* const* names, int count);
+
+// --instrument: every IR_LINE becomes `inc qword [rel jive_prof_counters+8*i]`.
+// After the last function, stack_machine_emit_profile_data writes the
+// counters and their line table (negative line = function entry) for
+// the runtime in tools/jive_rt.c.
+void stack_machine_set_instrument(bool on);
+void stack_machine_emit_profile_data(FILE* out, const char* source_path);
+
+// --regalloc: locals live in callee-saved registers (rbx, r12-r15) chosen
+// by linear scan; the used ones are saved below the locals in the frame.
+void stack_machine_set_regalloc(bool on);
+
+// -Os: shortest encodings instead of the uniform 64-bit forms: push
+// imm8/imm32, push/pop qword [rbp-N] for locals, constants folded into
+// their consumer (add qword [rsp], imm; imul rax, rax, imm; xor r32 / mov
+// r32, imm straight into a register when zero-extension is safe), pop+op
+// fused into memory-operand forms, and the most-used frame slots moved
+// to the low offsets that take disp8 addressing.
+void stack_machine_set_size_opt(bool on);
+
+// Bytes of machine code emitted so far by stack_machine_emit, from a
+// per-form encoding size model (jumps counted as rel32).
+long stack_machine_code_bytes(void);
@@ -31,6 +31,27 @@ void ir_print(IRList* ir) {
                 printf("%03d: MOD\n", i);
                 break;
 
+            case IR_SUB_R:
+            case IR_DIV_R:
+            case IR_MOD_R:
+            case IR_LT:
+            case IR_LE:
+            case IR_GT:
+            case IR_GE:
+            case IR_EQ:
+            case IR_NE:
+                printf("%03d: %s\n", i, ir_op_name(instr.op));
+                break;
+
+            case IR_LABEL:
+                printf("%03d: L%d:\n", i, instr.imm);
+                break;
+
+            case IR_JMP:
+            case IR_JZ:
+                printf("%03d: %s L%d\n", i, ir_op_name(instr.op), instr.imm);
+                break;
+
             // --- NEW for Compiler 4 ---
             case IR_LOAD:
                 printf("%03d: LOAD [rbp-%d]\n", i, instr.imm);
@@ -44,9 +65,345 @@ void ir_print(IRList* ir) {
                 printf("%03d: RET\n", i);
                 break;
 
+            case IR_PARAM:
+                printf("%03d: PARAM %d\n", i, instr.imm);
+                break;
+
+            case IR_ARG:
+                printf("%03d: ARG %d\n", i, instr.imm);
+                break;
+
+            case IR_CALL:
+                printf("%03d: CALL #%d\n", i, instr.imm);
+                break;
+
+            case IR_LINE:
+                printf("%03d: LINE %d\n", i, instr.imm);
+                break;
+
             default:
                 printf("%03d: (unknown IR %d)\n", i, instr.op);
                 break;
         }
     }
-}
\ No newline at end of file
+}
+
+const char* ir_op_name(IROp op) {
+    switch (op) {
+        case IR_PUSH_INT: return "PUSH_INT";
+        case IR_ADD:      return "ADD";
+        case IR_SUB:      return "SUB";
+        case IR_MUL:      return "MUL";
+        case IR_DIV:      return "DIV";
+        case IR_MOD:      return "MOD";
+        case IR_LOAD:     return "LOAD";
+        case IR_STORE:    return "STORE";
+        case IR_RET:      return "RET";
+        case IR_PARAM:    return "PARAM";
+        case IR_ARG:      return "ARG";
+        case IR_CALL:     return "CALL";
+        case IR_LINE:     return "LINE";
+        case IR_SUB_R:    return "SUB_R";
+        case IR_DIV_R:    return "DIV_R";
+        case IR_MOD_R:    return "MOD_R";
+        case IR_LT:       return "LT";
+        case IR_LE:       return "LE";
+        case IR_GT:       return "GT";
+        case IR_GE:       return "GE";
+        case IR_EQ:       return "EQ";
+        case IR_NE:       return "NE";
+        case IR_LABEL:    return "LABEL";
+        case IR_JMP:      return "JMP";
+        case IR_JZ:       return "JZ";
+        default:          return "?";
+    }
+}
+
+int ir_stack_effect(IROp op) {
+    switch (op) {
+        case IR_PUSH_INT:
+        case IR_LOAD:
+        case IR_PARAM:
+        case IR_CALL:
+            return 1;
+        case IR_ADD:
+        case IR_SUB:
+        case IR_MUL:
+        case IR_DIV:
+        case IR_MOD:
+        case IR_SUB_R:
+        case IR_DIV_R:
+        case IR_MOD_R:
+        case IR_LT:
+        case IR_LE:
+        case IR_GT:
+        case IR_GE:
+        case IR_EQ:
+        case IR_NE:
+        case IR_JZ:
+        case IR_STORE:
+        case IR_RET:
+        case IR_ARG:
+            return -1;
+        default:
+            return 0;
+    }
+}
+
+int ir_max_depth(const IRList* ir) {
+    int depth = 0, max = 0;
+    for (int i = 0; i < ir->count; i++) {
+        depth += ir_stack_effect(ir->code[i].op);
+        if (depth > max) max = depth;
+    }
+    return max;
+}
+
+// SysV integer argument registers: PARAM/ARG immediates index them
+#define MAX_ARGS 6
+
+bool ir_verify(const IRList* ir, int frame_bytes, char* msg, size_t msg_size) {
+    // label ids are dense per function, so one can never reach the count
+    int labels = 0;
+    for (int i = 0; i < ir->count; i++) {
+        IR in = ir->code[i];
+        if (in.op == IR_LABEL && (in.imm < 0 || in.imm >= ir->count)) {
+            snprintf(msg, msg_size, "%d: label id %d out of range", i, in.imm);
+            return false;
+        }
+        if (in.op == IR_LABEL && in.imm >= labels) labels = in.imm + 1;
+    }
+    int* defined = mem_alloc(ir->A, sizeof(int) * (labels + 1));
+    bool ok = true;
+    int depth = 0;
+
+    for (int i = 0; i < ir->count && ok; i++) {
+        IR in = ir->code[i];
+        if ((unsigned)in.op >= IR_OP_COUNT) {
+            snprintf(msg, msg_size, "%d: invalid opcode %d", i, (int)in.op);
+            ok = false;
+            break;
+        }
+        const char* name = ir_op_name(in.op);
+        // statement boundaries and control flow happen on an empty stack
+        bool boundary = in.op == IR_LABEL || in.op == IR_JMP || in.op == IR_LINE;
+        if (boundary && depth != 0) {
+            snprintf(msg, msg_size, "%d: %s with operand stack depth %d", i, name, depth);
+            ok = false;
+        } else if ((in.op == IR_LOAD || in.op == IR_STORE) &&
+                   (in.imm <= 0 || in.imm % 8 != 0 || in.imm > frame_bytes)) {
+            snprintf(msg, msg_size, "%d: %s [rbp-%d] outside the %d-byte frame", i, name, in.imm, frame_bytes);
+            ok = false;
+        } else if ((in.op == IR_PARAM || in.op == IR_ARG) && (in.imm < 0 || in.imm >= MAX_ARGS)) {
+            snprintf(msg, msg_size, "%d: %s #%d is not an argument register", i, name, in.imm);
+            ok = false;
+        } else if (in.op == IR_ARG && (i + 1 == ir->count ||
+                   (ir->code[i + 1].op != IR_ARG && ir->code[i + 1].op != IR_CALL))) {
+            // the emitter pops straight into argument registers: nothing
+            // may run between the ARGs and their CALL
+            snprintf(msg, msg_size, "%d: %s not followed by CALL", i, name);
+            ok = false;
+        } else if (in.op == IR_LABEL && defined[in.imm]++) {
+            snprintf(msg, msg_size, "%d: label %d defined twice", i, in.imm);
+            ok = false;
+        } else if ((in.op == IR_JMP || in.op == IR_JZ) && (in.imm < 0 || in.imm >= labels)) {
+            snprintf(msg, msg_size, "%d: %s to undefined label %d", i, name, in.imm);
+            ok = false;
+        }
+        if (!ok) break;
+
+        depth += ir_stack_effect(in.op);
+        if (depth < 0) {
+            snprintf(msg, msg_size, "%d: %s underflows the operand stack", i, name);
+            ok = false;
+        } else if ((in.op == IR_JZ || in.op == IR_RET) && depth != 0) {
+            snprintf(msg, msg_size, "%d: %s leaves operand stack depth %d", i, name, depth);
+            ok = false;
+        }
+    }
+    if (ok && depth != 0) {
+        snprintf(msg, msg_size, "end of function with operand stack depth %d", depth);
+        ok = false;
+    }
+    // a jump may target a label that is never placed
+    for (int i = 0; i < ir->count && ok; i++) {
+        IR in = ir->code[i];
+        if ((in.op == IR_JMP || in.op == IR_JZ) && !defined[in.imm]) {
+            snprintf(msg, msg_size, "%d: %s to undefined label %d", i, ir_op_name(in.op), in.imm);
+            ok = false;
+        }
+    }
+    mem_free(ir->A, defined);
+    return ok;
+}
+
+// Reference interpreter: mirrors stack_machine_emit instruction by
+// instruction (64-bit wrap-around, idiv faults) so generated code can
+// be measured and checked without assembling it.
+#define MAX_CALL_DEPTH 10000
+
+static bool interpret(const IRFunction* fns, int count, int index, const long long* args,
+                      int depth, long long* out_result, long* op_counts) {
+    if (index < 0 || index >= count || depth > MAX_CALL_DEPTH) return false;
+    const IRList* ir = fns[index].ir;
+    int frame_bytes = fns[index].frame_bytes;
+
+    int depth_cap = ir->count + 1;
+    long long* stack = mem_alloc(ir->A, sizeof(long long) * depth_cap);
+    long long* frame = mem_alloc(ir->A, sizeof(long long) * (frame_bytes / 8 + 2));
+    long long out_args[MAX_ARGS] = {0};
+    int sp = 0;
+    bool ok = true;
+    long long result = 0;
+
+    // Label id -> instruction index
+    int label_count = 0;
+    for (int i = 0; i < ir->count; i++) {
+        if (ir->code[i].op == IR_LABEL && ir->code[i].imm >= label_count) label_count = ir->code[i].imm + 1;
+    }
+    int* label_at = mem_alloc(ir->A, sizeof(int) * (label_count + 1));
+    for (int l = 0; l < label_count; l++) label_at[l] = -1;
+    for (int i = 0; i < ir->count; i++) {
+        if (ir->code[i].op == IR_LABEL && ir->code[i].imm >= 0) label_at[ir->code[i].imm] = i;
+    }
+
+#define POP2(a, b) do { if (sp < 2) { ok = false; break; } b = stack[--sp]; a = stack[--sp]; } while (0)
+
+    for (int i = 0; i < ir->count && ok; i++) {
+        IR instr = ir->code[i];
+        long long a = 0, b = 0;
+        if (sp >= depth_cap) { ok = false; break; }  // unbalanced loop
+        if (op_counts && instr.op < IR_OP_COUNT) op_counts[instr.op]++;
+
+        switch (instr.op) {
+            case IR_PUSH_INT:
+                stack[sp++] = instr.imm;
+                break;
+
+            case IR_ADD:
+                POP2(a, b);
+                if (ok) stack[sp++] = (long long)((unsigned long long)a + (unsigned long long)b);
+                break;
+
+            case IR_SUB:
+                POP2(a, b);
+                if (ok) stack[sp++] = (long long)((unsigned long long)a - (unsigned long long)b);
+                break;
+
+            case IR_MUL:
+                POP2(a, b);
+                if (ok) stack[sp++] = (long long)((unsigned long long)a * (unsigned long long)b);
+                break;
+
+            case IR_SUB_R:
+                POP2(b, a);  // a = top
+                if (ok) stack[sp++] = (long long)((unsigned long long)a - (unsigned long long)b);
+                break;
+
+            case IR_DIV:
+            case IR_MOD:
+            case IR_DIV_R:
+            case IR_MOD_R:
+                if (instr.op == IR_DIV || instr.op == IR_MOD) POP2(a, b);
+                else POP2(b, a);  // a = top
+                if (!ok || b == 0 || (b == -1 && a == (-9223372036854775807LL - 1))) {
+                    ok = false;
+                    break;
+                }
+                stack[sp++] = (instr.op == IR_DIV || instr.op == IR_DIV_R) ? a / b : a % b;
+                break;
+
+            case IR_LOAD:
+                if (instr.imm < 8 || instr.imm > frame_bytes) { ok = false; break; }
+                stack[sp++] = frame[instr.imm / 8];
+                break;
+
+            case IR_STORE:
+                if (sp < 1 || instr.imm < 8 || instr.imm > frame_bytes) { ok = false; break; }
+                frame[instr.imm / 8] = stack[--sp];
+                break;
+
+            case IR_RET:
+                if (sp < 1) { ok = false; break; }
+                result = stack[--sp];
+                i = ir->count;  // leave the function
+                break;
+
+            case IR_PARAM:
+                if (instr.imm < 0 || instr.imm >= MAX_ARGS) { ok = false; break; }
+                stack[sp++] = args ? args[instr.imm] : 0;
+                break;
+
+            case IR_ARG:
+                if (sp < 1 || instr.imm < 0 || instr.imm >= MAX_ARGS) { ok = false; break; }
+                out_args[instr.imm] = stack[--sp];
+                break;
+
+            case IR_CALL: {
+                long long r = 0;
+                ok = interpret(fns, count, instr.imm, out_args, depth + 1, &r, op_counts);
+                if (ok) stack[sp++] = r;
+                break;
+            }
+
+            case IR_LINE:
+            case IR_LABEL:
+                break;
+
+            case IR_LT:
+            case IR_LE:
+            case IR_GT:
+            case IR_GE:
+            case IR_EQ:
+            case IR_NE:
+                POP2(a, b);
+                if (!ok) break;
+                switch (instr.op) {
+                    case IR_LT: a = a < b; break;
+                    case IR_LE: a = a <= b; break;
+                    case IR_GT: a = a > b; break;
+                    case IR_GE: a = a >= b; break;
+                    case IR_EQ: a = a == b; break;
+                    default:    a = a != b; break;
+                }
+                stack[sp++] = a;
+                break;
+
+            case IR_JZ:
+                if (sp < 1) { ok = false; break; }
+                if (stack[--sp] != 0) break;
+                // fall through
+            case IR_JMP:
+                if (instr.imm < 0 || instr.imm >= label_count || label_at[instr.imm] < 0) {
+                    ok = false;
+                    break;
+                }
+                i = label_at[instr.imm];  // continue after the label
+                break;
+
+            default:
+                ok = false;
+                break;
+        }
+    }
+#undef POP2
+
+    mem_free(ir->A, stack);
+    mem_free(ir->A, frame);
+    mem_free(ir->A, label_at);
+    if (ok && out_result) *out_result = result;
+    return ok;
+}
+
+bool ir_interpret_call(const IRFunction* fns, int count, int entry,
+                       const long long* args, int argc,
+                       long long* out_result, long* op_counts) {
+    long long regs[MAX_ARGS] = {0};
+    for (int i = 0; i < argc && i < MAX_ARGS; i++) regs[i] = args[i];
+    return interpret(fns, count, entry, regs, 0, out_result, op_counts);
+}
+
+bool ir_interpret(const IRList* ir, int frame_bytes, long long* out_result, long* op_counts) {
+    IRFunction fn = { ir, frame_bytes };
+    return interpret(&fn, 1, 0, NULL, 0, out_result, op_counts);
+}
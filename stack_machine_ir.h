@@ -1,7 +1,11 @@
 #pragma once
+#include <stdbool.h>
 #include <stdlib.h>
+#include "alloc.h"
 
 // ---------- IR operation kinds ----------
+// The enum value doubles as the JIR opcode byte (see jir.h):
+// append new ops at the end and bump JIR_VERSION on any renumbering.
 typedef enum {
     IR_PUSH_INT,
     IR_ADD,
@@ -11,7 +15,24 @@ typedef enum {
     IR_MOD,
     IR_LOAD,   // new: load local variable from stack frame
     IR_STORE,  // new: store value into local variable
-    IR_RET
+    IR_RET,
+    IR_PARAM,  // push incoming argument #imm (function entry)
+    IR_ARG,    // pop into outgoing argument #imm
+    IR_CALL,   // call function #imm (module index), push its result
+    IR_LINE,   // statement boundary at source line #imm (first one: function entry)
+    IR_SUB_R,  // reversed operands: top - below (codegen evaluated rhs first)
+    IR_DIV_R,  // top / below
+    IR_MOD_R,  // top % below
+    IR_LT,     // pop b, pop a, push (a < b) as 0/1
+    IR_LE,
+    IR_GT,
+    IR_GE,
+    IR_EQ,
+    IR_NE,
+    IR_LABEL,  // jump target #imm (function-local); operand stack is empty here
+    IR_JMP,    // jump to label #imm
+    IR_JZ,     // pop; jump to label #imm if it was zero
+    IR_OP_COUNT // not an op: number of IROp values, keep last
 } IROp;
 
 // ---------- IR instruction ----------
@@ -25,19 +46,62 @@ typedef struct {
     IR* code;
     int count;
     int cap;
+    Allocator* A;
 } IRList;
 
 // ---------- IR functions ----------
-static inline void ir_init(IRList* L) {
+static inline void ir_init(IRList* L, Allocator* A) {
     L->code = NULL;
     L->count = 0;
     L->cap = 0;
+    L->A = A ? A : alloc_system();
+}
+
+static inline void ir_free(IRList* L) {
+    mem_free(L->A, L->code);
+    L->code = NULL;
+    L->count = L->cap = 0;
 }
 
 static inline void ir_emit(IRList* L, IROp op, int imm) {
     if (L->count == L->cap) {
         L->cap = (L->cap == 0) ? 64 : L->cap * 2;
-        L->code = realloc(L->code, sizeof(IR) * L->cap);
+        L->code = mem_realloc(L->A, L->code, sizeof(IR) * L->cap);
     }
     L->code[L->count++] = (IR){ .op = op, .imm = imm };
-}
\ No newline at end of file
+}
+
+// ---------- Debugging / measurement (stack_machine_ir.c) ----------
+void ir_print(IRList* ir);
+const char* ir_op_name(IROp op);
+
+// Net operand-stack effect of one instruction (pushes minus pops).
+int ir_stack_effect(IROp op);
+
+// Peak operand-stack depth (in slots). Jumps happen at depth 0, so a
+// linear scan gives the same answer as following the control flow.
+int ir_max_depth(const IRList* ir);
+
+// Check what codegen guarantees and the emitter relies on: the operand
+// stack never underflows and is empty at every LINE, LABEL, JMP, after
+// every JZ and RET and at the end; jumps target labels placed exactly
+// once and label ids are in range; LOAD/STORE slots lie inside
+// frame_bytes; PARAM/ARG name one of the 6 argument registers and a run
+// of ARGs ends in its CALL. On failure writes
+// "<index>: <problem>" to msg and returns false.
+bool ir_verify(const IRList* ir, int frame_bytes, char* msg, size_t msg_size);
+
+// One function of a module, as seen by the interpreter.
+typedef struct {
+    const IRList* ir;
+    int frame_bytes;
+} IRFunction;
+
+// Execute IR on a 64-bit operand stack, like the generated code would.
+// op_counts (IR_OP_COUNT entries, may be NULL) receives how many times
+// each op ran. Returns false if execution would fault (idiv by zero or
+// overflow, runaway recursion) or the IR is malformed.
+bool ir_interpret_call(const IRFunction* fns, int count, int entry,
+                       const long long* args, int argc,
+                       long long* out_result, long* op_counts);
+bool ir_interpret(const IRList* ir, int frame_bytes, long long* out_result, long* op_counts);
@@ -6,7 +6,7 @@
 // ----------------------------------------------------------
 // Helper: hash function for strings (djb2 style)
 // ----------------------------------------------------------
-static unsigned long hash_string(const char* str) {
+unsigned long symbol_hash(const char* str) {
     unsigned long hash = 5381;
     int c;
     while ((c = *str++)) {
@@ -20,16 +20,39 @@ static unsigned long hash_string(const char* str) {
 // ----------------------------------------------------------
 
 Symbol_Table make_symbol_table(long number_of_slots) {
+    return make_symbol_table_with(NULL, number_of_slots);
+}
+
+Symbol_Table make_symbol_table_with(Allocator* A, long number_of_slots) {
+    if (!A) A = alloc_system();
     Symbol_Table result = {
-        .symbols = calloc(number_of_slots, sizeof(Symbol*)),
+        .symbols = mem_alloc(A, number_of_slots * sizeof(Symbol*)),
         .number_of_slots = number_of_slots,
-        .entry_count = 0
+        .entry_count = 0,
+        .A = A
     };
     return result;
 }
 
+void free_symbol_table(Symbol_Table* table) {
+    for (long i = 0; i < table->number_of_slots; i++) {
+        Symbol* curr = table->symbols[i];
+        while (curr) {
+            Symbol* next = curr->next;
+            mem_free(table->A, curr->name);
+            mem_free(table->A, curr);
+            curr = next;
+        }
+    }
+    mem_free(table->A, table->symbols);
+    table->symbols = NULL;
+    table->number_of_slots = 0;
+    table->entry_count = 0;
+    table->grow_count = 0;
+}
+
 bool insert_symbol(Symbol_Table* table, const char* name, Symbol_Data data) {
-    unsigned long h = hash_string(name) % table->number_of_slots;
+    unsigned long h = symbol_hash(name) % table->number_of_slots;
     Symbol* curr = table->symbols[h];
 
     // Check for duplicate declaration
@@ -42,8 +65,8 @@ bool insert_symbol(Symbol_Table* table, const char* name, Symbol_Data data) {
     }
 
     // Create new symbol
-    Symbol* new_sym = malloc(sizeof(Symbol));
-    new_sym->name = strdup(name);
+    Symbol* new_sym = mem_alloc(table->A, sizeof(Symbol));
+    new_sym->name = mem_strdup(table->A, name);
     new_sym->offset = data.variable_slot;   // store offset
     new_sym->data = data;
     new_sym->next = table->symbols[h];
@@ -57,7 +80,7 @@ bool insert_symbol(Symbol_Table* table, const char* name, Symbol_Data data) {
 }
 
 Symbol_Data* lookup_symbol(Symbol_Table* table, const char* name) {
-    unsigned long h = hash_string(name) % table->number_of_slots;
+    unsigned long h = symbol_hash(name) % table->number_of_slots;
     Symbol* curr = table->symbols[h];
     while (curr) {
         if (strcmp(curr->name, name) == 0) {
@@ -69,86 +92,140 @@ Symbol_Data* lookup_symbol(Symbol_Table* table, const char* name) {
 }
 
 void grow_table(Symbol_Table* table, long new_number_of_slots) {
-    Symbol** new_symbols = calloc(new_number_of_slots, sizeof(Symbol*));
+    Symbol** new_symbols = mem_alloc(table->A, new_number_of_slots * sizeof(Symbol*));
 
     for (long i = 0; i < table->number_of_slots; i++) {
         Symbol* curr = table->symbols[i];
         while (curr) {
             Symbol* next = curr->next;
-            unsigned long h = hash_string(curr->name) % new_number_of_slots;
+            unsigned long h = symbol_hash(curr->name) % new_number_of_slots;
             curr->next = new_symbols[h];
             new_symbols[h] = curr;
             curr = next;
         }
     }
 
-    free(table->symbols);
+    mem_free(table->A, table->symbols);
     table->symbols = new_symbols;
     table->number_of_slots = new_number_of_slots;
+    table->grow_count++;
 }
 
 // ----------------------------------------------------------
 // Symbol stack (scope management)
 // ----------------------------------------------------------
 
-SymStack* symstack_new() {
-    SymStack* s = calloc(1, sizeof(SymStack));
+SymStack* symstack_new(Allocator* A) {
+    if (!A) A = alloc_system();
+    SymStack* s = mem_alloc(A, sizeof(SymStack));
+    s->A = A;
+    s->table = make_symbol_table_with(A, 16);
+    s->log_capacity = 16;
+    s->log = mem_alloc(A, s->log_capacity * sizeof(Symbol*));
     s->capacity = 8;
     s->depth = 0;
-    s->tables = calloc(s->capacity, sizeof(Symbol_Table));
+    s->marks = mem_alloc(A, s->capacity * sizeof(Scope_Mark));
     s->next_offset = 8;  // each var = 8 bytes
+    s->max_offset = 8;
     return s;
 }
 
 void symstack_free(SymStack* s) {
     if (!s) return;
-    free(s->tables);
-    free(s);
+    while (s->depth > 0) symstack_pop_scope(s);
+    free_symbol_table(&s->table);
+    mem_free(s->A, s->log);
+    mem_free(s->A, s->marks);
+    mem_free(s->A, s);
+}
+
+// Link that points at name's visible binding, or the NULL ending its bucket
+static Symbol** binding_link(Symbol_Table* t, const char* name) {
+    Symbol** link = &t->symbols[symbol_hash(name) % t->number_of_slots];
+    while (*link && strcmp((*link)->name, name) != 0) link = &(*link)->next;
+    return link;
 }
 
 void symstack_push_scope(SymStack* s) {
     if (s->depth >= s->capacity) {
         s->capacity *= 2;
-        s->tables = realloc(s->tables, s->capacity * sizeof(Symbol_Table));
+        s->marks = mem_realloc(s->A, s->marks, s->capacity * sizeof(Scope_Mark));
     }
-    s->tables[s->depth++] = make_symbol_table(16);
+    s->marks[s->depth++] = (Scope_Mark){ s->log_count, s->next_offset };
 }
 
+// Undo the scope's declarations newest first, so each one is still the
+// visible binding of its name when it is unlinked
 void symstack_pop_scope(SymStack* s) {
-    if (s->depth > 0) s->depth--;
+    if (s->depth == 0) return;
+    Scope_Mark m = s->marks[--s->depth];
+    while (s->log_count > m.log_count) {
+        Symbol* sym = s->log[--s->log_count];
+        Symbol** link = binding_link(&s->table, sym->name);
+        if (sym->shadowed) {
+            sym->shadowed->next = sym->next;
+            *link = sym->shadowed;
+        } else {
+            *link = sym->next;
+            s->table.entry_count--;
+        }
+        mem_free(s->A, sym->name);
+        mem_free(s->A, sym);
+    }
+    s->next_offset = m.next_offset;  // slots of the popped scope are free again
 }
 
 int symstack_total_locals(SymStack* s) {
-    return s->next_offset - 8;  // total bytes allocated
+    return s->max_offset - 8;  // bytes of the deepest nesting reached
+}
+
+// Start a new function: frame slots restart at [rbp-8]
+void symstack_reset_frame(SymStack* s) {
+    s->next_offset = 8;
+    s->max_offset = 8;
 }
 
 // Declare a new variable in the current scope
 bool symstack_declare(SymStack* s, const char* name, int* out_offset) {
     if (s->depth == 0) symstack_push_scope(s);
-    Symbol_Table* top = &s->tables[s->depth - 1];
-
-    Symbol_Data data = {.variable_slot = s->next_offset};
+    Symbol** link = binding_link(&s->table, name);
+    Symbol* outer = *link;
+    if (outer && outer->depth == s->depth) return false;
+
+    Symbol* sym = mem_alloc(s->A, sizeof(Symbol));
+    sym->name = mem_strdup(s->A, name);
+    sym->offset = s->next_offset;
+    sym->data.variable_slot = s->next_offset;
+    sym->depth = s->depth;
+    sym->shadowed = outer;
+    if (outer) {
+        // take the outer binding's place in the chain
+        sym->next = outer->next;
+        outer->next = NULL;
+        *link = sym;
+    } else {
+        Symbol** head = &s->table.symbols[symbol_hash(name) % s->table.number_of_slots];
+        sym->next = *head;
+        *head = sym;
+        s->table.entry_count++;
+        if ((double)s->table.entry_count / s->table.number_of_slots > 0.7) {
+            grow_table(&s->table, s->table.number_of_slots * 2);
+        }
+    }
 
-    if (!insert_symbol(top, name, data)) {
-        return false;
+    if (s->log_count == s->log_capacity) {
+        s->log_capacity *= 2;
+        s->log = mem_realloc(s->A, s->log, s->log_capacity * sizeof(Symbol*));
     }
+    s->log[s->log_count++] = sym;
 
     *out_offset = s->next_offset;
     s->next_offset += 8; // move stack by 8 bytes
+    if (s->next_offset > s->max_offset) s->max_offset = s->next_offset;
     return true;
 }
 
-// Look up variable across all active scopes
+// Look up the innermost visible binding of name
 Symbol* symstack_lookup(SymStack* s, const char* name) {
-    for (int i = s->depth - 1; i >= 0; i--) {
-        Symbol_Data* found = lookup_symbol(&s->tables[i], name);
-        if (found) {
-            Symbol* sym = malloc(sizeof(Symbol));
-            sym->name = strdup(name);
-            sym->offset = found->variable_slot;
-            sym->data = *found;
-            return sym;
-        }
-    }
-    return NULL;
-}
\ No newline at end of file
+    return *binding_link(&s->table, name);
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <stdbool.h>
+#include "alloc.h"
 
 // ---------- Basic symbol data ----------
 typedef struct {
@@ -12,6 +13,8 @@ typedef struct Symbol {
     int offset;            // <--- NEW: offset for stack variable
     Symbol_Data data;
     struct Symbol* next;
+    struct Symbol* shadowed;  // SymStack: outer binding this one hides
+    int depth;                // SymStack: scope that declared it (1 = outermost)
 } Symbol;
 
 // ---------- Hash table ----------
@@ -19,27 +22,53 @@ typedef struct {
     Symbol** symbols;
     long number_of_slots;
     long entry_count;
+    long grow_count;       // rehashes so far (bench/symtab_bench.c)
+    Allocator* A;
 } Symbol_Table;
 
 // ---------- Symbol stack (scope manager) ----------
+// One hash table holds the innermost binding of every visible name. A
+// declaration that shadows an outer one takes its place in the bucket
+// chain and keeps it on `shadowed`, so a lookup is one probe however
+// deep the nesting. Declarations are appended to an undo log; popping a
+// scope unlinks the symbols logged since its mark (restoring whatever
+// they shadowed) and hands their frame slots back to the next scope.
+typedef struct {
+    int log_count;    // undo log length when the scope was pushed
+    int next_offset;  // first free frame slot when the scope was pushed
+} Scope_Mark;
+
 typedef struct SymStack {
-    Symbol_Table* tables;
+    Symbol_Table table;
+    Symbol** log;          // undo log: declarations, oldest first
+    int log_count;
+    int log_capacity;
+    Scope_Mark* marks;     // one per open scope
     int depth;
     int capacity;
     int next_offset;
+    int max_offset;        // high-water mark of next_offset: the frame size
+    Allocator* A;
 } SymStack;
 
 // ---------- Function declarations ----------
+unsigned long symbol_hash(const char* name);  // bucket = hash % number_of_slots
 Symbol_Table make_symbol_table(long number_of_slots);
+Symbol_Table make_symbol_table_with(Allocator* A, long number_of_slots);
+void free_symbol_table(Symbol_Table* table);
 bool insert_symbol(Symbol_Table* table, const char* name, Symbol_Data data);
 Symbol_Data* lookup_symbol(Symbol_Table* table, const char* name);
 void grow_table(Symbol_Table* table, long new_number_of_slots);
 
 // ---------- Scope management API ----------
-SymStack* symstack_new();
+SymStack* symstack_new(Allocator* A);
 void symstack_free(SymStack* s);
 void symstack_push_scope(SymStack* s);
 void symstack_pop_scope(SymStack* s);
 int symstack_total_locals(SymStack* s);
+void symstack_reset_frame(SymStack* s);
+// Fails if name is already declared in the innermost scope; declaring a
+// name from an outer scope shadows it until the scope is popped.
 bool symstack_declare(SymStack* s, const char* name, int* out_offset);
+// Returns the symbol stored in the table (owned by the scope, do not free).
 Symbol* symstack_lookup(SymStack* s, const char* name);
\ No newline at end of file
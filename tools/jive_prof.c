@@ -0,0 +1,133 @@
+// ==========================================================
+// jive_prof: map `--instrument` counters back to Jive source lines
+//
+// Reads the profile written by tools/jive_rt.c and prints the source
+// with each line's execution count (statement counters on the same
+// line are summed; `fn` headers show the function-entry count),
+// followed by the hottest lines.
+//
+// Build (from the repo root):
+//   gcc -O2 -o jive_prof tools/jive_prof.c
+// Run:
+//   ./jive_prof [jive.prof] [source.jive]   (source defaults to the profile's,
+//                                            required if it records none)
+// ==========================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_HOT 10
+
+typedef struct {
+    long long count;  // executions of statements on this line
+    long long calls;  // entries of the function declared on this line
+    int stmts;        // statement counters seen (0: not instrumented)
+    int fns;
+} LineProf;
+
+static LineProf* lines = NULL;
+static int line_cap = 0;
+
+static LineProf* line_at(int line) {
+    if (line >= line_cap) {
+        int cap = line_cap ? line_cap : 64;
+        while (cap <= line) cap *= 2;
+        lines = realloc(lines, sizeof(LineProf) * cap);
+        memset(lines + line_cap, 0, sizeof(LineProf) * (cap - line_cap));
+        line_cap = cap;
+    }
+    return &lines[line];
+}
+
+static int cmp_hot(const void* a, const void* b) {
+    long long x = lines[*(const int*)a].count, y = lines[*(const int*)b].count;
+    return (x < y) - (x > y);
+}
+
+int main(int argc, char** argv) {
+    const char* prof_path = argc > 1 ? argv[1] : "jive.prof";
+    FILE* f = fopen(prof_path, "r");
+    if (!f) {
+        fprintf(stderr, "Error: cannot open profile %s\n", prof_path);
+        return 1;
+    }
+
+    // ---- Read the profile ----
+    char buf[1024];
+    char source[1024] = "";
+    long long total = 0;
+    while (fgets(buf, sizeof buf, f)) {
+        char kind[8];
+        int line;
+        long long count;
+        if (buf[0] == '#') continue;
+        if (strncmp(buf, "source ", 7) == 0) {
+            snprintf(source, sizeof source, "%s", buf + 7);
+            source[strcspn(source, "\n")] = '\0';
+        } else if (sscanf(buf, "%7s %d %lld", kind, &line, &count) == 3 && line >= 0) {
+            LineProf* lp = line_at(line);
+            if (strcmp(kind, "fn") == 0) {
+                lp->calls += count;
+                lp->fns++;
+            } else {
+                lp->count += count;
+                lp->stmts++;
+                total += count;
+            }
+        } else {
+            fprintf(stderr, "Error: malformed profile line: %s", buf);
+            fclose(f);
+            return 1;
+        }
+    }
+    fclose(f);
+
+    const char* src_path = argc > 2 ? argv[2] : source;
+    if (!src_path[0]) {
+        fprintf(stderr, "Error: %s names no source file; pass it as the second argument\n", prof_path);
+        return 1;
+    }
+    FILE* src = fopen(src_path, "r");
+    if (!src) {
+        fprintf(stderr, "Error: cannot open source %s\n", src_path);
+        return 1;
+    }
+
+    // ---- Annotated listing ----
+    printf("%12s %5s | %s\n", "count", "line", src_path);
+    int line = 1;
+    while (fgets(buf, sizeof buf, src)) {
+        buf[strcspn(buf, "\n")] = '\0';
+        LineProf* lp = line < line_cap ? &lines[line] : NULL;
+        if (lp && lp->fns) {
+            printf("%11lldx %5d | %s\n", lp->calls, line, buf);
+            if (lp->stmts) printf("%12lld %5s |\n", lp->count, "");
+        } else if (lp && lp->stmts) {
+            printf("%12lld %5d | %s\n", lp->count, line, buf);
+        } else {
+            printf("%12s %5d | %s\n", "", line, buf);
+        }
+        line++;
+    }
+    fclose(src);
+
+    // ---- Hottest statement lines ----
+    int hot[MAX_HOT], nhot = 0;
+    int* order = malloc(sizeof(int) * (line_cap + 1));
+    int n = 0;
+    for (int i = 0; i < line_cap; i++) {
+        if (lines[i].stmts) order[n++] = i;
+    }
+    qsort(order, n, sizeof(int), cmp_hot);
+    for (int i = 0; i < n && nhot < MAX_HOT; i++) hot[nhot++] = order[i];
+    free(order);
+
+    printf("\nHottest lines (%lld statement executions):\n", total);
+    for (int i = 0; i < nhot; i++) {
+        LineProf* lp = &lines[hot[i]];
+        printf("  line %5d: %12lld  (%.1f%%)\n", hot[i], lp->count,
+               total ? 100.0 * lp->count / total : 0.0);
+    }
+    free(lines);
+    return 0;
+}
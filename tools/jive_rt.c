@@ -0,0 +1,44 @@
+// ==========================================================
+// Profiling runtime for `--instrument` builds
+//
+// Link this file with an instrumented program. At exit it writes the
+// counters emitted by stack_machine_emit_profile_data to the file named
+// by $JIVE_PROF (default jive.prof), one line per counter:
+//
+//   # jive-prof v1
+//   source main.jive              (omitted if the build had no source path)
+//   <fn|stmt> <line> <count>
+//
+// tools/jive_prof.c turns that file into an annotated source listing.
+// ==========================================================
+#include <stdio.h>
+#include <stdlib.h>
+
+extern long long jive_prof_count;
+extern long long jive_prof_counters[];
+extern int jive_prof_lines[];   // negative: function entry
+extern char jive_prof_source[];
+
+static void jive_prof_dump(void) {
+    const char* path = getenv("JIVE_PROF");
+    if (!path || !*path) path = "jive.prof";
+
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "jive_rt: cannot write profile %s\n", path);
+        return;
+    }
+    fprintf(out, "# jive-prof v1\n");
+    if (jive_prof_source[0]) fprintf(out, "source %s\n", jive_prof_source);
+    for (long long i = 0; i < jive_prof_count; i++) {
+        int line = jive_prof_lines[i];
+        fprintf(out, "%s %d %lld\n", line < 0 ? "fn" : "stmt",
+                line < 0 ? -line : line, jive_prof_counters[i]);
+    }
+    fclose(out);
+}
+
+__attribute__((constructor))
+static void jive_prof_init(void) {
+    atexit(jive_prof_dump);
+}